@@ -37,6 +37,7 @@
 #include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
 #include <cstring>  // memcopy
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <optional>
@@ -100,30 +101,27 @@ std::optional<T> read(const std::filesystem::path& file,
     std::cout << "Now Reading: " << file << std::endl;
 
     try {
-        std::unique_ptr<std::istream> file_stream;
-
-        // For most files < 1Gb, pre-loading the entire file upfront and
-        // wrapping it into a stream is a net win for parsing speed,
-        // about 40% faster.
-        if (preload_into_memory) {
+        namespace ply = tinyply;
 
-            std::vector<uint8_t> byte_buffer = read_file_binary(file);
-            file_stream.reset(new BufferedStream(std::move(byte_buffer)));
+        std::unique_ptr<ply::ByteSource> source;
+        std::ifstream file_stream;
+
+        // For most files < 1Gb, mapping the entire file upfront and
+        // parsing it in place is a net win for parsing speed.
+        if (preload_into_memory)
+            source = std::make_unique<ply::MappedFile>(file);
+        else {
+            file_stream.open(file, std::ios::binary);
+            if (file_stream.fail())
+                throw std::runtime_error("file_stream failed to open " + file.string());
+            source = std::make_unique<ply::StreamSource>(file_stream);
         }
-        else
-            file_stream.reset(new std::ifstream(file, std::ios::binary));
 
-        if (!file_stream || file_stream->fail())
-            throw std::runtime_error("file_stream failed to open " + file.string());
+        const float size_mb = std::filesystem::file_size(file) * float(1e-6);
 
-        file_stream->seekg(0, std::ios::end);
-        const float size_mb = file_stream->tellg() * float(1e-6);
-        file_stream->seekg(0, std::ios::beg);
-
-        namespace ply = tinyply;
         ply::FileIn file;
 
-        file.parse_header(*file_stream);
+        file.parse_header(*source);
 
         file.report_structure();
 
@@ -222,7 +220,7 @@ std::optional<T> read(const std::filesystem::path& file,
         manual_timer read_timer;
 
         read_timer.start();
-        file.read(*file_stream);
+        file.read(*source);
         read_timer.stop();
 
         const float parsing_time = static_cast<float>(read_timer.get()) / 1000.f;
@@ -240,17 +238,17 @@ std::optional<T> read(const std::filesystem::path& file,
         // Example One: converting to your own application types
         T body;
 
-        const size_t sizeVertices = vertices->buffer.size_bytes();
-        body.vertices.resize(vertices->count);
-        std::memcpy(body.vertices.data(), vertices->buffer.get(), sizeVertices);
+        body.vertices.reserve(vertices->count);
+        for (const auto v : vertices->as_rows<float>())
+            body.vertices.push_back({v[0], v[1], v[2]});
 
-        const size_t sizeNormals = normals->buffer.size_bytes();
-        body.normals.resize(normals->count);
-        std::memcpy(body.normals.data(), normals->buffer.get(), sizeNormals);
+        body.normals.reserve(normals->count);
+        for (const auto n : normals->as_rows<float>())
+            body.normals.push_back({n[0], n[1], n[2]});
 
-        const size_t sizeTexCs = texcoords->buffer.size_bytes();
-        body.texcoords.resize(texcoords->count);
-        std::memcpy(body.texcoords.data(), texcoords->buffer.get(), sizeTexCs);
+        body.texcoords.reserve(texcoords->count);
+        for (const auto t : texcoords->as_rows<float>())
+            body.texcoords.push_back({t[0], t[1]});
 
         body.set_triangles(Cube::quads);
 
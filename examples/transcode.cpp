@@ -0,0 +1,69 @@
+
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Converts a ply file between the ascii and binary encodings, record by
+// record, so that files larger than memory can be converted:
+//
+//     transcode <input.ply> <output.ply> ascii|binary|binary_big_endian
+
+#include "transcoder.h"
+#include "utils.h"
+
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+int main(int argc, char *argv[])
+{
+    namespace ply = tinyply;
+
+    if (argc != 4) {
+        std::cerr << "usage: " << argv[0]
+                  << " <input.ply> <output.ply> ascii|binary|binary_big_endian"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string_view format {argv[3]};
+
+    try {
+        const auto encoding = ply::encoding_from_name(format);
+
+        manual_timer timer;
+        timer.start();
+        ply::transcode(argv[1], argv[2], encoding);
+        timer.stop();
+
+        std::cout << "transcoded " << argv[1] << " to " << format
+                  << " in " << timer.get() << " ms" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Caught tinyply exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -38,75 +38,6 @@
 #include <thread>
 #include <vector>
 
-inline
-std::vector<uint8_t> read_file_binary(const std::filesystem::path& file)
-{
-    std::ifstream ifs(file, std::ios::binary);
-    std::vector<uint8_t> fileBufferBytes;
-
-    if (ifs.is_open()) {
-
-        ifs.seekg(0, std::ios::end);
-        size_t sizeBytes = ifs.tellg();
-        ifs.seekg(0, std::ios::beg);
-        fileBufferBytes.resize(sizeBytes);
-        if (ifs.read((char*)fileBufferBytes.data(), sizeBytes))
-            return fileBufferBytes;
-    }
-    else
-        throw std::runtime_error("could not open binary ifstream to path " + file.string());
-
-    return fileBufferBytes;
-}
-
-struct memory_buffer
-    : public std::streambuf {
-
-    std::vector<uint8_t> b;
-    size_t size;
-    char* p_start {};
-    char* p_end {};
-
-    memory_buffer(std::vector<uint8_t>&& bb)
-        : b {std::move(bb)}
-        , size {b.size()}
-        , p_start {reinterpret_cast<char*>(b.data())}
-        , p_end {p_start + size}
-    {
-        setg(p_start, p_start, p_end);
-    }
-
-    pos_type seekoff(const off_type off,
-                     std::ios_base::seekdir dir,
-                     std::ios_base::openmode which) override
-    {
-        if (dir == std::ios_base::cur)
-            gbump(static_cast<int>(off));
-        else
-            setg(p_start,
-                (dir == std::ios_base::beg ? p_start : p_end) + off,
-                p_end);
-
-        return gptr() - p_start;
-    }
-
-    pos_type seekpos(const pos_type pos,
-                     std::ios_base::openmode which) override
-    {
-        return seekoff(pos, std::ios_base::beg, which);
-    }
-};
-
-struct BufferedStream
-    : virtual memory_buffer
-    , public std::istream {
-
-    explicit BufferedStream(std::vector<uint8_t>&& b)
-        : memory_buffer {std::move(b)}
-        , std::istream(static_cast<std::streambuf*>(this))
-    {}
-};
-
 class manual_timer {
 
     using Clock = std::chrono::high_resolution_clock;
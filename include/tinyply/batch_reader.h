@@ -0,0 +1,201 @@
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TINYPLY_BATCH_READER_H
+#define TINYPLY_BATCH_READER_H
+
+#include "impl/data_buffer.h"
+#include "impl/file_loader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>  // function
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tinyply {
+
+    using Request = impl::Request;
+
+    /**
+     * Reads the same set of properties from many files concurrently.
+     * Each worker thread keeps its reader and data buffers from one file to
+     * the next, so per-file allocations happen only as long as the files grow.
+     */
+    class BatchReader {
+
+        std::vector<Request> requests;
+        size_t numThreads {};
+
+    public:
+
+        using Data = impl::Data;
+
+        struct Result {
+
+            std::filesystem::path path;
+            size_t index {};  ///< position of `path` in the input list
+
+            /// One per request, in the order of the requests; empty if the
+            /// file does not contain the requested element or properties.
+            std::vector<std::shared_ptr<Data>> data;
+
+            /// Requested elements and properties missing from the file,
+            /// and requests it could not satisfy otherwise.
+            std::vector<std::string> skipped;
+
+            std::exception_ptr error;  ///< set if the file could not be read
+        };
+
+        /**
+         * `numThreads` bounds the number of files read at the same time;
+         * zero selects the number of hardware threads.
+         */
+        explicit BatchReader(std::vector<Request> requests,
+                             size_t numThreads = 0);
+
+        /**
+         * Reads all the files and returns the results in the order of `paths`.
+         */
+        std::vector<Result> read(const std::vector<std::filesystem::path>& paths);
+
+        /**
+         * Reads all the files, passing each result to `onResult` on the
+         * calling thread as soon as it is complete. Buffers of the results
+         * the callback does not keep are recycled for subsequent files: all
+         * use of a result must be over by the time its last copy is released.
+         */
+        void read(const std::vector<std::filesystem::path>& paths,
+                  const std::function<void(Result&&)>& onResult);
+    };
+
+}  // namespace tinyply
+
+
+// IMPLEMENTATION ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+#ifdef TINYPLY_AS_LIBRARY
+
+namespace tinyply {
+
+BatchReader::
+BatchReader(std::vector<Request> requests,
+            const size_t numThreads)
+    : requests {std::move(requests)}
+    , numThreads {numThreads ? numThreads
+                             : std::max(1u, std::thread::hardware_concurrency())}
+{}
+
+std::vector<BatchReader::Result> BatchReader::
+read(const std::vector<std::filesystem::path>& paths)
+{
+    std::vector<Result> results(paths.size());
+
+    read(paths, [&results](Result&& r) {
+        results[r.index] = std::move(r);
+    });
+
+    return results;
+}
+
+void BatchReader::
+read(const std::vector<std::filesystem::path>& paths,
+     const std::function<void(Result&&)>& onResult)
+{
+    std::atomic<size_t> next {};
+    std::mutex mutex;
+    std::condition_variable resultReady;
+    std::condition_variable slotFree;
+    std::deque<Result> completed;
+    bool stop {};
+
+    // At most `numThreads` completed results wait for the caller,
+    // which bounds the memory held when `onResult` is the bottleneck.
+    auto work = [&]() {
+
+        impl::FileLoader loader;
+
+        for (size_t i = next++; i < paths.size(); i = next++) {
+
+            Result r;
+            r.path = paths[i];
+            r.index = i;
+            try {
+                r.data = loader.load(paths[i], requests);
+                r.skipped = std::move(loader.skipped);
+            }
+            catch (...) {
+                r.error = std::current_exception();
+            }
+
+            std::unique_lock lock {mutex};
+            slotFree.wait(lock, [&] {
+                return stop || completed.size() < numThreads;
+            });
+            if (stop)
+                return;
+            completed.push_back(std::move(r));
+            resultReady.notify_one();
+        }
+    };
+
+    std::vector<std::jthread> workers;
+    const auto n = std::min(numThreads, paths.size());
+    for (size_t i {}; i < n; ++i)
+        workers.emplace_back(work);
+
+    try {
+        for (size_t received {}; received < paths.size(); ++received) {
+
+            std::unique_lock lock {mutex};
+            resultReady.wait(lock, [&] { return !completed.empty(); });
+            Result r = std::move(completed.front());
+            completed.pop_front();
+            slotFree.notify_one();
+            lock.unlock();
+
+            onResult(std::move(r));
+        }
+    }
+    catch (...) {
+        {
+            std::scoped_lock lock {mutex};
+            stop = true;
+            next = paths.size();
+        }
+        slotFree.notify_all();
+        throw;  // the workers are joined while unwinding
+    }
+}
+
+}  // namespace tinyply
+
+#endif  // TINYPLY_AS_LIBRARY
+#endif  // TINYPLY_BATCH_READER_H
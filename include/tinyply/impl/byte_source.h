@@ -0,0 +1,518 @@
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TINYPLY_IMPL_BYTE_SOURCE_H
+#define TINYPLY_IMPL_BYTE_SOURCE_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
+#include <cstring>  // memcpy, memchr
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>  // open
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>  // read, lseek, close
+#endif
+
+namespace tinyply::impl {
+
+    /**
+     * Input of the parser, handing out the bytes of a file in spans as
+     * large as it has them: memory and mapped files in a single span,
+     * streams and file descriptors a buffer at a time. Other inputs,
+     * e.g. a decompressor, implement `pull` and, if they can go back for
+     * the counting pass of lists read without a size hint, `seek` and `tell`.
+     */
+    class ByteSource {
+
+    public:
+
+        virtual ~ByteSource() = default;
+
+        /**
+         * The next bytes of the input, empty at its end. The span stays
+         * valid until the next call to `pull` or `seek`.
+         */
+        virtual std::span<const uint8_t> pull() = 0;
+
+        /**
+         * Moves to `offset` bytes from the start of the source.
+         * \returns false if the source cannot go there.
+         */
+        virtual bool seek(uint64_t offset)
+        {
+            (void)offset;
+            return false;
+        }
+
+        /// Offset of the next byte `pull` hands out.
+        virtual uint64_t tell() const noexcept
+        {
+            return 0;
+        }
+    };
+
+
+    /**
+     * Source over a block of memory it does not own, e.g. a whole file
+     * loaded in one go or a message payload.
+     */
+    class MemorySource
+        : public ByteSource {
+
+        std::span<const uint8_t> bytes;
+        size_t at {};
+
+    public:
+
+        explicit MemorySource(std::span<const uint8_t> bytes) noexcept
+            : bytes {bytes}
+        {}
+
+        std::span<const uint8_t> pull() override
+        {
+            const auto rest = bytes.subspan(at);
+            at = bytes.size();
+            return rest;
+        }
+
+        bool seek(const uint64_t offset) override
+        {
+            if (offset > bytes.size())
+                return false;
+            at = static_cast<size_t>(offset);
+            return true;
+        }
+
+        uint64_t tell() const noexcept override
+        {
+            return at;
+        }
+    };
+
+
+    /**
+     * Source reading a std::istream a buffer at a time. Bytes buffered past
+     * those parsed are given back by seeking the stream, if it can seek.
+     */
+    class StreamSource
+        : public ByteSource {
+
+        std::istream& is;
+        std::istream::pos_type start;
+        std::vector<uint8_t> buffer;
+        uint64_t at {};
+
+    public:
+
+        static constexpr size_t defaultBufferSize {size_t(1) << 20};
+
+        explicit StreamSource(std::istream& is,
+                              const size_t bufferSize = defaultBufferSize)
+            : is {is}
+            , start {is.tellg()}
+            , buffer(bufferSize)
+        {}
+
+        std::span<const uint8_t> pull() override
+        {
+            is.read(reinterpret_cast<char*>(buffer.data()),
+                    static_cast<std::streamsize>(buffer.size()));
+            const auto n = static_cast<size_t>(is.gcount());
+            at += n;
+            return {buffer.data(), n};
+        }
+
+        bool seek(const uint64_t offset) override
+        {
+            if (start == std::istream::pos_type(-1))
+                return false;
+            is.clear();
+            is.seekg(start + std::streamoff(offset));
+            at = offset;
+            return !is.fail();
+        }
+
+        uint64_t tell() const noexcept override
+        {
+            return at;
+        }
+    };
+
+
+#if defined(__unix__) || defined(__APPLE__)
+
+    /**
+     * Source reading an open file descriptor a buffer at a time, e.g. of a
+     * pipe or a socket. The descriptor is not closed by the source.
+     */
+    class FdSource
+        : public ByteSource {
+
+        int fd;
+        off_t start;
+        std::vector<uint8_t> buffer;
+        uint64_t at {};
+
+    public:
+
+        explicit FdSource(const int fd,
+                          const size_t bufferSize = StreamSource::defaultBufferSize)
+            : fd {fd}
+            , start {::lseek(fd, 0, SEEK_CUR)}
+            , buffer(bufferSize)
+        {}
+
+        std::span<const uint8_t> pull() override
+        {
+            ssize_t n;
+            do
+                n = ::read(fd, buffer.data(), buffer.size());
+            while (n < 0 && errno == EINTR);
+            if (n < 0)
+                throw std::runtime_error("failed to read the input");
+
+            at += static_cast<uint64_t>(n);
+            return {buffer.data(), static_cast<size_t>(n)};
+        }
+
+        bool seek(const uint64_t offset) override
+        {
+            if (start < 0 ||
+                ::lseek(fd, start + static_cast<off_t>(offset), SEEK_SET) < 0)
+                return false;
+            at = offset;
+            return true;
+        }
+
+        uint64_t tell() const noexcept override
+        {
+            return at;
+        }
+    };
+
+#endif
+
+
+    /**
+     * Source over a whole file, memory mapped where available
+     * and otherwise read into memory.
+     */
+    class MappedFile
+        : public MemorySource {
+
+        struct Contents {
+
+            std::span<const uint8_t> bytes;
+            std::vector<uint8_t> copy;  ///< where the file is not mapped
+            void* map {};
+        };
+
+        Contents contents;
+
+        MappedFile(Contents&& c)
+            : MemorySource {c.copy.empty() ? c.bytes : std::span<const uint8_t> {c.copy}}
+            , contents {std::move(c)}
+        {}
+
+        static Contents open(const std::filesystem::path& path)
+        {
+            Contents c;
+#if defined(__unix__) || defined(__APPLE__)
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd >= 0) {
+                struct stat st {};
+                void* map = MAP_FAILED;
+                if (::fstat(fd, &st) == 0 && st.st_size > 0)
+                    map = ::mmap(nullptr, static_cast<size_t>(st.st_size),
+                                 PROT_READ, MAP_PRIVATE, fd, 0);
+                ::close(fd);
+                if (map != MAP_FAILED) {
+                    c.map = map;
+                    c.bytes = {static_cast<const uint8_t*>(map),
+                               static_cast<size_t>(st.st_size)};
+                    return c;
+                }
+            }
+#endif
+            std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+            if (ifs.fail())
+                throw std::runtime_error("failed to open " + path.string());
+
+            c.copy.resize(static_cast<size_t>(ifs.tellg()));
+            ifs.seekg(0, std::ios::beg);
+            if (!ifs.read(reinterpret_cast<char*>(c.copy.data()), c.copy.size()))
+                throw std::runtime_error("failed to read " + path.string());
+
+            return c;
+        }
+
+    public:
+
+        explicit MappedFile(const std::filesystem::path& path)
+            : MappedFile {open(path)}
+        {}
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile() override
+        {
+#if defined(__unix__) || defined(__APPLE__)
+            if (contents.map)
+                ::munmap(contents.map, contents.bytes.size());
+#endif
+        }
+
+        std::span<const uint8_t> bytes() const noexcept
+        {
+            return contents.copy.empty() ? contents.bytes
+                                         : std::span<const uint8_t> {contents.copy};
+        }
+    };
+
+
+    /**
+     * Cursor of the parser over a source: values are copied and tokens
+     * are cut straight out of the spans the source hands out, so that
+     * a source in memory is parsed in place.
+     */
+    class ByteReader {
+
+        ByteSource* source {};
+        const uint8_t* first {};
+        const uint8_t* cur {};
+        const uint8_t* last {};
+        uint64_t base {};   ///< offset of `first` in the source
+        std::string spill;  ///< a token or line split between spans
+
+        static constexpr bool is_space(const uint8_t c) noexcept
+        {
+            return c == ' ' || (c >= '\t' && c <= '\r');
+        }
+
+        bool refill()
+        {
+            base += static_cast<uint64_t>(last - first);
+            const auto next = source->pull();
+            first = cur = next.data();
+            last = first + next.size();
+            return !next.empty();
+        }
+
+    public:
+
+        ByteReader() = default;
+
+        explicit ByteReader(ByteSource& source) noexcept
+            : source {&source}
+            , base {source.tell()}
+        {}
+
+        bool bound() const noexcept
+        {
+            return source != nullptr;
+        }
+
+        bool reads_from(const ByteSource& s) const noexcept
+        {
+            return source == &s;
+        }
+
+        /// Offset of the next byte in the source.
+        uint64_t tell() const noexcept
+        {
+            return base + static_cast<uint64_t>(cur - first);
+        }
+
+        /**
+         * Moves to `offset` bytes from the start of the source, within the
+         * span at hand if possible; throws if the source cannot seek.
+         */
+        void seek(const uint64_t offset)
+        {
+            if (offset >= base && offset <= base + static_cast<uint64_t>(last - first)) {
+                cur = first + (offset - base);
+                return;
+            }
+            if (!source->seek(offset))
+                throw std::runtime_error("the input cannot be read twice; "
+                                         "request lists with a size hint");
+            base = offset;
+            first = cur = last = nullptr;
+        }
+
+        /**
+         * Leaves the source at the next byte to parse, handing back what is
+         * buffered past it, e.g. for a stream read on by the caller.
+         */
+        void release()
+        {
+            if (source)
+                source->seek(tell());
+            base = tell();
+            first = cur = last = nullptr;
+        }
+
+        /// \returns the number of bytes copied, less than `n` at the end.
+        size_t read(void* dst,
+                    const size_t n)
+        {
+            if (static_cast<size_t>(last - cur) >= n) {
+                std::memcpy(dst, cur, n);
+                cur += n;
+                return n;
+            }
+            auto* d = static_cast<uint8_t*>(dst);
+            size_t done {};
+            while (done < n && (cur < last || refill())) {
+                const size_t k = std::min(n - done, static_cast<size_t>(last - cur));
+                std::memcpy(d + done, cur, k);
+                cur += k;
+                done += k;
+            }
+            return done;
+        }
+
+        /**
+         * Up to `maxRecords` whole records of `recordBytes` bytes, in place
+         * unless a record spans two of the source spans; empty at the end.
+         * The view stays valid until the next call.
+         */
+        std::span<const uint8_t> records(const size_t recordBytes,
+                                         const size_t maxRecords)
+        {
+            if (cur == last)
+                refill();
+
+            const size_t n = std::min(maxRecords,
+                                      static_cast<size_t>(last - cur) / recordBytes);
+            if (n) {
+                const std::span<const uint8_t> whole {cur, n * recordBytes};
+                cur += n * recordBytes;
+                return whole;
+            }
+            spill.resize(recordBytes);
+            if (read(spill.data(), recordBytes) != recordBytes)
+                return {};
+            return {reinterpret_cast<const uint8_t*>(spill.data()), recordBytes};
+        }
+
+        size_t skip(const size_t n)
+        {
+            size_t done {};
+            while (done < n && (cur < last || refill())) {
+                const size_t k = std::min(n - done, static_cast<size_t>(last - cur));
+                cur += k;
+                done += k;
+            }
+            return done;
+        }
+
+        /**
+         * The next whitespace-delimited token, empty at the end of the input.
+         * The view stays valid until the next call.
+         */
+        std::string_view token()
+        {
+            do
+                while (cur < last && is_space(*cur))
+                    ++cur;
+            while (cur == last && refill());
+
+            const auto* start = cur;
+            while (cur < last && !is_space(*cur))
+                ++cur;
+            if (cur < last || cur == start)
+                return {reinterpret_cast<const char*>(start),
+                        static_cast<size_t>(cur - start)};
+
+            // The token may go on in the next span.
+            spill.assign(start, cur);
+            while (refill()) {
+                while (cur < last && !is_space(*cur))
+                    ++cur;
+                spill.append(first, cur);
+                if (cur < last)
+                    break;
+            }
+            return spill;
+        }
+
+        /**
+         * The next line, without its '\n'.
+         * \returns false at the end of the input.
+         */
+        bool line(std::string_view& out)
+        {
+            if (cur == last && !refill())
+                return false;
+
+            if (const auto* eol = static_cast<const uint8_t*>(
+                    std::memchr(cur, '\n', static_cast<size_t>(last - cur)))) {
+                out = {reinterpret_cast<const char*>(cur),
+                       static_cast<size_t>(eol - cur)};
+                cur = eol + 1;
+                return true;
+            }
+
+            spill.assign(cur, last);
+            cur = last;
+            while (refill()) {
+                const auto* eol = static_cast<const uint8_t*>(
+                    std::memchr(cur, '\n', static_cast<size_t>(last - cur)));
+                spill.append(cur, eol ? eol : last);
+                cur = eol ? eol + 1 : last;
+                if (eol)
+                    break;
+            }
+            out = spill;
+            return true;
+        }
+    };
+
+}  // namespace tinyply::impl
+
+namespace tinyply {
+
+    using ByteSource = impl::ByteSource;
+    using MemorySource = impl::MemorySource;
+    using StreamSource = impl::StreamSource;
+    using MappedFile = impl::MappedFile;
+#if defined(__unix__) || defined(__APPLE__)
+    using FdSource = impl::FdSource;
+#endif
+
+}  // namespace tinyply
+
+#endif  // TINYPLY_IMPL_BYTE_SOURCE_H
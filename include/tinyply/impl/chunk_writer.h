@@ -0,0 +1,286 @@
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TINYPLY_IMPL_CHUNK_WRITER_H
+#define TINYPLY_IMPL_CHUNK_WRITER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
+#include <cstring>  // memcpy
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <utility>  // pair
+#include <vector>
+
+namespace tinyply::impl {
+
+    /**
+     * Background thread writing filled chunks to a stream, so that
+     * encoding the next chunk overlaps with writing the previous one.
+     * At most `maxPending` chunks wait or are being written at a time;
+     * written chunks are handed back for reuse.
+     */
+    class WriteBehind {
+
+        std::ostream& os;
+        const size_t maxPending;
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<std::pair<std::vector<uint8_t>, size_t>> queued;
+        std::vector<std::vector<uint8_t>> spare;
+        size_t pending {};  ///< queued or being written
+        std::exception_ptr error;
+        bool closing {};
+
+        std::jthread thread;  // last, as it uses the members above
+
+        void run()
+        {
+            std::unique_lock lock {mutex};
+            while (true) {
+
+                changed.wait(lock, [this] { return closing || !queued.empty(); });
+                if (queued.empty())
+                    return;
+
+                auto [chunk, used] = std::move(queued.front());
+                queued.pop_front();
+                const bool failed = bool(error);
+                lock.unlock();
+
+                if (!failed)
+                    os.write(reinterpret_cast<const char*>(chunk.data()), used);
+
+                lock.lock();
+                if (!failed && os.fail())
+                    error = std::make_exception_ptr(
+                        std::runtime_error("failed to write the output")
+                    );
+                spare.push_back(std::move(chunk));
+                --pending;
+                changed.notify_all();
+            }
+        }
+
+    public:
+
+        WriteBehind(std::ostream& os,
+                    const size_t maxPending)
+            : os {os}
+            , maxPending {std::max<size_t>(1, maxPending)}
+            , thread {[this] { run(); }}
+        {}
+
+        ~WriteBehind()
+        {
+            {
+                std::scoped_lock lock {mutex};
+                closing = true;
+            }
+            changed.notify_all();
+        }
+
+        /**
+         * Queues the first `used` bytes of `chunk` for writing, waiting for
+         * room in the queue, and returns a spare chunk, possibly empty.
+         */
+        std::vector<uint8_t> push(std::vector<uint8_t>&& chunk,
+                                  const size_t used)
+        {
+            std::unique_lock lock {mutex};
+            changed.wait(lock, [this] { return pending < maxPending; });
+            if (error)
+                std::rethrow_exception(error);
+
+            queued.emplace_back(std::move(chunk), used);
+            ++pending;
+            changed.notify_all();
+
+            std::vector<uint8_t> next;
+            if (!spare.empty()) {
+                next = std::move(spare.back());
+                spare.pop_back();
+            }
+            return next;
+        }
+
+        /**
+         * Waits until everything queued is written; rethrows write errors.
+         */
+        void drain()
+        {
+            std::unique_lock lock {mutex};
+            changed.wait(lock, [this] { return pending == 0; });
+            if (error)
+                std::rethrow_exception(error);
+        }
+    };
+
+    /**
+     * Staging buffer collecting the output in large chunks, so that the
+     * stream is written to once per chunk rather than once per value.
+     * Without a stream, the buffer grows to keep everything in memory.
+     * With `queuedChunks`, full chunks are written by a background thread.
+     */
+    class ChunkWriter {
+
+        std::ostream* os {};
+        std::vector<uint8_t> chunk;
+        size_t used {};
+        std::unique_ptr<WriteBehind> behind;
+
+        void make_room(const size_t n)
+        {
+            if (os)
+                hand_off();
+            if (used + n > chunk.size())
+                chunk.resize(std::max(used + n, 2 * chunk.size()));
+        }
+
+        // Writes to the stream directly, failing as the background writes do.
+        void write_through(const void* src,
+                           const size_t n)
+        {
+            os->write(static_cast<const char*>(src), n);
+            if (os->fail())
+                throw std::runtime_error("failed to write the output");
+        }
+
+        // Passes the staged bytes on, without waiting for a background write.
+        void hand_off()
+        {
+            if (!behind) {
+                write_through(chunk.data(), used);
+            }
+            else if (used) {
+                const size_t size = chunk.size();
+                chunk = behind->push(std::move(chunk), used);
+                chunk.resize(size);
+            }
+            used = 0;
+        }
+
+    public:
+
+        static constexpr size_t defaultChunkSize {size_t(1) << 22};  // 4 MiB
+
+        explicit ChunkWriter(std::ostream& os,
+                             const size_t chunkSize = defaultChunkSize,
+                             const size_t queuedChunks = 0)
+            : os {&os}
+            , chunk(chunkSize)
+            , behind {queuedChunks ? std::make_unique<WriteBehind>(os, queuedChunks)
+                                   : nullptr}
+        {}
+
+        ChunkWriter() = default;
+
+        /**
+         * Returns space for at least `n` bytes, to be followed by `commit(...)`
+         * for the number of bytes actually written there.
+         */
+        uint8_t* reserve(const size_t n)
+        {
+            if (used + n > chunk.size())
+                make_room(n);
+
+            return chunk.data() + used;
+        }
+
+        void commit(const size_t n) noexcept
+        {
+            used += n;
+        }
+
+        void append(const void* src,
+                    size_t n)
+        {
+            if (used + n > chunk.size()) {
+                if (os && !behind && n >= chunk.size()) {  // large runs bypass the staging
+                    flush();
+                    write_through(src, n);
+                    return;
+                }
+                if (behind && n >= chunk.size()) {  // go through in full chunks
+                    const auto* p = static_cast<const uint8_t*>(src);
+                    for (size_t k; n; p += k, n -= k) {
+                        k = std::min(n, chunk.size() - used);
+                        std::memcpy(chunk.data() + used, p, k);
+                        used += k;
+                        if (used == chunk.size())
+                            hand_off();
+                    }
+                    return;
+                }
+                make_room(n);
+            }
+            std::memcpy(chunk.data() + used, src, n);
+            used += n;
+        }
+
+        /**
+         * Writes out everything appended so far.
+         */
+        void flush()
+        {
+            hand_off();
+            if (behind)
+                behind->drain();
+        }
+
+        const uint8_t* data() const noexcept
+        {
+            return chunk.data();
+        }
+
+        size_t size() const noexcept
+        {
+            return used;
+        }
+
+        void clear() noexcept
+        {
+            used = 0;
+        }
+
+        /**
+         * Hands over the bytes kept in memory, leaving the writer empty.
+         */
+        std::vector<uint8_t> release() noexcept
+        {
+            chunk.resize(used);
+            used = 0;
+            return std::move(chunk);
+        }
+    };
+
+}  // namespace tinyply::impl
+
+#endif  // TINYPLY_IMPL_CHUNK_WRITER_H
@@ -29,6 +29,9 @@
 
 #include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
 #include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
 
 namespace tinyply::impl {
 
@@ -42,6 +45,7 @@ namespace tinyply::impl {
         std::unique_ptr<uint8_t, decltype(Buffer::delete_array())> data;
 
         size_t size {};
+        size_t capacity {};
         uint8_t* alias {};
 
     public:
@@ -50,6 +54,7 @@ namespace tinyply::impl {
         explicit Buffer(const size_t size)
             : data (new uint8_t[size], delete_array())
             , size {size}
+            , capacity {size}
             , alias {data.get()}  // allocating
         {}
 
@@ -71,6 +76,96 @@ namespace tinyply::impl {
         {
             return size;
         }
+
+        /**
+         * Sets the size to `newSize` bytes, allocating only if the buffer
+         * does not own enough memory already. The contents are not preserved.
+         */
+        void resize(const size_t newSize)
+        {
+            if (!data || newSize > capacity) {
+                data.reset(new uint8_t[newSize]);
+                capacity = newSize;
+                alias = data.get();
+            }
+            size = newSize;
+        }
+    };
+
+
+    /**
+     * Records of `width` values each, over a flat span of values, e.g.
+     * N x 3 positions or the lists of a fixed-length list property.
+     */
+    template<typename T>
+    class Rows {
+
+        std::span<T> values;
+        size_t width {};
+
+    public:
+
+        constexpr Rows(std::span<T> values,
+                       const size_t width) noexcept
+            : values {values}
+            , width {width}
+        {}
+
+        constexpr size_t size() const noexcept
+        {
+            return width ? values.size() / width : 0;
+        }
+
+        constexpr size_t components() const noexcept
+        {
+            return width;
+        }
+
+        constexpr std::span<T> operator[](const size_t i) const noexcept
+        {
+            return values.subspan(i * width, width);
+        }
+
+        constexpr std::span<T> flat() const noexcept
+        {
+            return values;
+        }
+
+        class iterator {
+
+            const Rows* rows {};
+            size_t i {};
+
+        public:
+
+            constexpr iterator(const Rows* rows, const size_t i) noexcept
+                : rows {rows}
+                , i {i}
+            {}
+
+            constexpr std::span<T> operator*() const noexcept
+            {
+                return (*rows)[i];
+            }
+
+            constexpr iterator& operator++() noexcept
+            {
+                ++i;
+                return *this;
+            }
+
+            constexpr bool operator==(const iterator&) const noexcept = default;
+        };
+
+        constexpr iterator begin() const noexcept
+        {
+            return {this, 0};
+        }
+
+        constexpr iterator end() const noexcept
+        {
+            return {this, size()};
+        }
     };
 
 
@@ -80,6 +175,7 @@ namespace tinyply::impl {
         Buffer buffer;
         size_t count {};  // how many items are in the element?
         bool isList {};
+        size_t recordStride {};  ///< of records of mixed types, with `t` invalid
 
         explicit Data(
             const Type t,
@@ -105,6 +201,62 @@ namespace tinyply::impl {
 
         size_t num_items() const noexcept;
 
+        /**
+         * The values as a typed view of the buffer, without copying.
+         * `T` must be the type of the values or, for records of mixed
+         * types, a struct of the record size; throws otherwise.
+         */
+        template<typename T>
+        std::span<T> as_span()
+        {
+            check_view_type<std::remove_const_t<T>>();
+            return {reinterpret_cast<T*>(buffer.get()),
+                    buffer.size_bytes() / sizeof(T)};
+        }
+
+        template<typename T>
+        std::span<const T> as_span() const
+        {
+            check_view_type<std::remove_const_t<T>>();
+            return {reinterpret_cast<const T*>(buffer.get()),
+                    buffer.size_bytes() / sizeof(T)};
+        }
+
+        /**
+         * The values grouped by record: `count` rows of the properties
+         * of a group, or of the values of a list.
+         */
+        template<typename T>
+        Rows<T> as_rows()
+        {
+            const auto values = as_span<T>();
+            return {values, count ? values.size() / count : 0};
+        }
+
+        template<typename T>
+        Rows<const T> as_rows() const
+        {
+            const auto values = as_span<T>();
+            return {values, count ? values.size() / count : 0};
+        }
+
+    private:
+
+        template<typename T>
+        void check_view_type() const
+        {
+            bool valid {};
+            if (t == Type::INVALID)
+                valid = recordStride == sizeof(T);
+            else if constexpr (std::is_arithmetic_v<T>)
+                valid = type_of<T> == t;
+
+            if (!valid)
+                throw std::invalid_argument("the data are not of the viewed type");
+        }
+
+    public:
+
         void endian_reverse() noexcept;
     };
 
@@ -124,6 +276,9 @@ namespace tinyply::impl {
     size_t Data::
     num_items() const noexcept
     {
+        if (t == Type::INVALID)
+            return recordStride ? buffer.size_bytes() / recordStride : 0;
+
         return (buffer.size_bytes() / types.at(t).stride);
     }
 
@@ -42,7 +42,6 @@ namespace tinyply::impl {
 
         std::vector<Property> properties;
 
-        explicit Element(std::istream& istream);
         explicit constexpr Element(const std::string& name);
         explicit constexpr Element(
             const std::string& name,
@@ -71,12 +70,6 @@ namespace tinyply::impl {
 
 namespace tinyply::impl {
 
-Element::
-Element(std::istream& is)
-{
-    is >> name >> size;
-}
-
 constexpr
 Element::
 Element(const std::string& name)
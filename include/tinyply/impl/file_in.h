@@ -24,8 +24,10 @@
 #ifndef TINYPLY_IMPL_FILE_IN_H
 #define TINYPLY_IMPL_FILE_IN_H
 
+#include "impl/byte_source.h"
 #include "impl/data_buffer.h"
 #include "impl/header.h"
+#include "impl/interleave.h"
 
 #include <algorithm>
 #include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
@@ -34,19 +36,74 @@
 #include <fstream>
 #include <functional>  // function
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <set>
+#include <string>
+#include <utility>  // exchange
+#include <vector>
 
 namespace tinyply::impl {
 
+/**
+ * Memory required by a read, as known after the header is parsed and the
+ * properties are requested.
+ */
+struct ReadPlan {
+
+    struct Group {
+
+        std::string element;
+        std::vector<std::string> properties;
+        std::shared_ptr<Data> data;  ///< as returned by the request
+        size_t bytes {};             ///< buffer size; a lower bound if not exact
+        bool exact {true};           ///< false for lists read without a size hint
+    };
+
+    std::vector<Group> groups;  ///< one per `request_properties_from_element`
+    size_t totalBytes {};       ///< peak memory of all the buffers
+    bool countingPass {};       ///< an extra pass is needed to size the lists
+};
+
+
 struct FileIn {
 
     using PropertyLookup = Header::PropertyLookup;
 
-    uint8_t scratch[64]; // large enough for max list size
     Header header;
 
+    // Cursor over the source passed to `Reader::parse_header`, so that
+    // the next `read(ByteSource&)` goes on from the bytes it has already
+    // pulled. Unbound by the other `parse_header` overloads and by the read.
+    ByteReader input;
+
+    // Compiled on the first read and kept as long as the requests are
+    // unchanged, so that files sharing a header schema reuse it.
+    std::vector<std::vector<PropertyLookup>> lookupTable;
+
+    /**
+     * Records of a bound struct, decoded by the loop compiled for it.
+     */
+    struct BoundRecords {
+
+        std::string element;
+        std::shared_ptr<Data> data;
+        RecordDecoder decode {};
+        RecordLayout layout;
+    };
+    std::vector<BoundRecords> boundRecords;
+
     void read(std::istream& is);
+    void read(ByteSource& source);
+    void read(ByteReader& in);
+
+    /**
+     * Forgets the header, the requests and the source, so that another
+     * file can be read, keeping the memory of the containers for it.
+     */
+    void reset() noexcept;
+
+    ReadPlan plan() const;
     Element* request_element(const std::string_view& elementKey);
 
     std::shared_ptr<Data> request_properties_from_element(
@@ -55,10 +112,29 @@ struct FileIn {
         const uint32_t list_size_hint=0
     );
 
+    /**
+     * If `reuse` is given, the properties are read into it rather than
+     * into a newly created Data, and its buffer memory is recycled.
+     */
     std::shared_ptr<Data> request_properties_from_element(
         const Element& element,
         const std::vector<std::string> propertyKeys,
-        const uint32_t list_size_hint
+        const uint32_t list_size_hint,
+        std::shared_ptr<Data> reuse = nullptr
+    );
+
+    /**
+     * Reads properties of different types into one array of records of
+     * `stride` bytes, each field at its offset. A field type must match
+     * the file or be left invalid; lists must have the length `listCount`.
+     * With `decode`, compiled for these fields, binary elements of
+     * fixed-size records are decoded by it.
+     */
+    std::shared_ptr<Data> request_record_from_element(
+        const std::string& elementKey,
+        const std::vector<Field>& fields,
+        size_t stride,
+        RecordDecoder decode = nullptr
     );
 
     size_t read_property_binary(
@@ -66,7 +142,7 @@ struct FileIn {
         void* dest,
         size_t& destOffset,
         size_t destSize,
-        std::istream& is
+        ByteReader& in
     );
 
     size_t read_property_ascii(
@@ -75,11 +151,49 @@ struct FileIn {
         void* dest,
         size_t& destOffset,
         size_t destSize,
-        std::istream& is
+        ByteReader& in
     );
 
-    void parse_data(std::istream& is,
+    void parse_data(ByteReader& in,
                     bool firstPass);
+
+    /**
+     * Offsets of the elements of a binary file from the start of the
+     * source, followed by the end of the last one, with `in` at the start
+     * of the data. Elements of fixed-size records are skipped over in one
+     * go; those holding lists are scanned for the list lengths.
+     */
+    std::vector<uint64_t> element_offsets(ByteReader& in);
+
+    /**
+     * The helper of records requested with the layout of the file, so that
+     * the element can be read in one go; nullptr otherwise.
+     */
+    static ParsingHelper const* whole_records(
+        const Element& element,
+        const std::vector<PropertyLookup>& lookups
+    ) noexcept;
+
+    /**
+     * The bound records to be decoded if they are all that is requested
+     * from the element; nullptr otherwise.
+     */
+    BoundRecords const* bound_records(
+        const Element& element,
+        const std::vector<PropertyLookup>& lookups
+    ) const noexcept;
+
+    static void decode_bound_records(const BoundRecords& records,
+                                     const Element& element,
+                                     ByteReader& in);
+
+    /**
+     * Index of the last element having at least one requested property,
+     * or -1 if nothing is requested.
+     */
+    static int64_t last_requested_element(
+        const std::vector<std::vector<PropertyLookup>>& lookupTable
+    ) noexcept;
 };
 
 }  // namespace tinyply::impl
@@ -90,6 +204,22 @@ struct FileIn {
 
 namespace tinyply::impl {
 
+void FileIn::
+reset() noexcept
+{
+    header.userData.dataMap.clear();
+    header.isBinary = false;
+    header.isBigEndian = false;
+    header.elements.clear();
+    header.comments.clear();
+    header.objInfo.clear();
+    header.headerBytes = 0;
+
+    input = {};
+    lookupTable.clear();
+    boundRecords.clear();
+}
+
 Element* FileIn::
 request_element(const std::string_view& elementKey)
 {
@@ -120,7 +250,8 @@ request_properties_from_element(const std::string& elementKey,
 std::shared_ptr<Data> FileIn::
 request_properties_from_element(const Element& element,
                                 std::vector<std::string> propertyKeys,
-                                const uint32_t list_size_hint)
+                                const uint32_t list_size_hint,
+                                std::shared_ptr<Data> reuse)
 {
     if (propertyKeys.empty())
         throw std::invalid_argument("`propertyKeys` argument is empty");
@@ -145,7 +276,8 @@ request_properties_from_element(const Element& element,
         );
     else if (scalarTypes.size() > 1)
         throw std::invalid_argument(
-            "all requested properties must share the scalar type"
+            "all requested properties must share the scalar type; "
+            "request properties of mixed types as a record"
         );
 
     // Each key in `propertyKeys` gets an entry into the userData map (keyed
@@ -157,9 +289,13 @@ request_properties_from_element(const Element& element,
     // That way, properties like, {"x", "y", "z"} will all be put into the
     // same buffer.
 
-    auto data = std::make_shared<Data>(Type::INVALID,
-                                       element.size,  // number of 'element.name' records
-                                       false);        // not a list
+    auto data = reuse ? std::move(reuse)
+                      : std::make_shared<Data>(Type::INVALID,
+                                               element.size,  // number of 'element.name' records
+                                               false);        // not a list
+    data->count = element.size;
+
+    lookupTable.clear();
 
     ParsingHelper helper {data,
                           std::make_shared<DataCursor>(),
@@ -176,9 +312,85 @@ request_properties_from_element(const Element& element,
     return data;
 }
 
+std::shared_ptr<Data> FileIn::
+request_record_from_element(const std::string& elementKey,
+                            const std::vector<Field>& fields,
+                            const size_t stride,
+                            const RecordDecoder decode)
+{
+    const auto element = request_element(elementKey);
+    if (!element)
+        throw std::invalid_argument(
+            "requested element " + elementKey + " not found"
+        );
+    if (fields.empty())
+        throw std::invalid_argument("`fields` argument is empty");
+
+    for (const auto& f: fields) {
+        const auto property = element->get_property(f.name);  // or throws
+        if (f.type != Type::INVALID && f.type != property->scalarType)
+            throw std::invalid_argument("property '" + f.name + "' is of type " +
+                                        std::string(types.at(property->scalarType).str));
+        if (property->is_list() && !f.listCount)
+            throw std::invalid_argument("list '" + f.name +
+                                        "' needs a fixed `listCount`");
+
+        const size_t bytes = types.at(property->scalarType).stride *
+                             (property->is_list() ? f.listCount : 1);
+        if (f.offset + bytes > stride)
+            throw std::invalid_argument("property '" + f.name +
+                                        "' exceeds the record stride");
+    }
+
+    auto data = std::make_shared<Data>(Type::INVALID, element->size, false);
+    data->recordStride = stride;
+
+    lookupTable.clear();
+
+    for (const auto& f: fields) {
+        const auto property = element->get_property(f.name);
+        ParsingHelper helper {data,
+                              std::make_shared<DataCursor>(),
+                              static_cast<uint32_t>(f.listCount)};
+        helper.offset = f.offset;
+        helper.stride = stride;
+        header.userData.insert(*element, *property, std::move(helper));
+    }
+
+    if (!decode || !header.isBinary)
+        return data;
+
+    // The file records must be of fixed size: lists not in the fields
+    // leave the positions of the properties after them unknown.
+    BoundRecords bound {element->name, data, decode, {}};
+    bound.layout.at.resize(fields.size());
+    bound.layout.countBytes.resize(fields.size());
+    bound.layout.bigEndian = header.isBigEndian;
+
+    auto& at = bound.layout.recordBytes;
+    for (const auto& p: element->properties) {
+
+        const auto f = std::ranges::find(fields, p.name, &Field::name);
+        if (p.is_list() && f == fields.end())
+            return data;
+
+        const size_t k = static_cast<size_t>(f - fields.begin());
+        if (p.is_list()) {
+            bound.layout.countBytes[k] = types.at(p.listType).stride;
+            at += bound.layout.countBytes[k];
+        }
+        if (f != fields.end())
+            bound.layout.at[k] = at;
+        at += types.at(p.scalarType).stride * (p.is_list() ? f->listCount : 1);
+    }
+    boundRecords.push_back(std::move(bound));
+
+    return data;
+}
+
 
 void FileIn::
-parse_data(std::istream& is,
+parse_data(ByteReader& in,
            const bool firstPass)
 {
     std::function<void(PropertyLookup& f,
@@ -186,47 +398,57 @@ parse_data(std::istream& is,
                        uint8_t* dest,
                        size_t& destOffset,
                        size_t destSize,
-                       std::istream& is)> read;
+                       ByteReader& in)> read;
 
     std::function<size_t(PropertyLookup& f,
                          const Property& p,
-                         std::istream& is)> skip;
+                         ByteReader& in)> skip;
 
-    const auto start = is.tellg();
+    const auto start = in.tell();
 
     uint32_t listSize {};
     size_t dummyCount {};
-    std::string skip_ascii_buffer;
+
+    // Lists read into user records must not run into the following fields.
+    size_t maxListSize {std::numeric_limits<size_t>::max()};
+    auto check_list_size = [&listSize, &maxListSize](const Property& p) {
+        if (listSize > maxListSize)
+            throw std::runtime_error(
+                "list '" + p.name + "' is not of the requested length"
+            );
+    };
 
     // Special case mirroring read_property_binary but for list types; this
     // has an additional big endian check to flip the data in place immediately
     // after reading. We do this as a performance optimization; endian flipping
     // is done on regular properties as a post-process after reading (also for
-    // optimization) but we need the correct little-endian list count as we
-    // read the file.
+    // optimization) but we need the correct list count as we read the file.
+    // The count is left in the whole of the `uint32_t` at `dst`.
     auto read_list_binary = [this](const Type& t,
-                                   void* dst,
+                                   uint32_t* dst,
                                    size_t& destOffset,
                                    const size_t stride,
-                                   std::istream& _is) noexcept
+                                   ByteReader& _in)
     {
         destOffset += stride;
-        _is.read((char*)dst, stride);
+        _in.read(dst, stride);
 
         if (header.isBigEndian)
             endian_reverse(t, dst);
+        *dst = load_list_count(t, dst);
 
         return stride;
     };
 
     if (header.isBinary) {
 
-        read = [this, &listSize, &dummyCount, &read_list_binary](PropertyLookup& f,
-                                                                 const Property& p,
-                                                                 uint8_t* dest,
-                                                                 size_t& destOffset,
-                                                                 const size_t destSize,
-                                                                 std::istream& _is)
+        read = [this, &listSize, &dummyCount, &read_list_binary, &check_list_size](
+            PropertyLookup& f,
+            const Property& p,
+            uint8_t* dest,
+            size_t& destOffset,
+            const size_t destSize,
+            ByteReader& _in)
         {
             if (!p.is_list())
 
@@ -234,28 +456,29 @@ parse_data(std::istream& is,
                                             dest + destOffset,
                                             destOffset,
                                             destSize,
-                                            _is);
+                                            _in);
 
             read_list_binary(p.listType,
                              &listSize,
                              dummyCount,
                              f.list_stride,
-                             _is); // the list size
+                             _in); // the list size
+            check_list_size(p);
 
             return read_property_binary(f.prop_stride * listSize,
                                         dest + destOffset,
                                         destOffset,
                                         destSize,
-                                        _is); // properties in list
+                                        _in); // properties in list
         };
 
         skip = [this, &listSize, &dummyCount, &read_list_binary](PropertyLookup& f,
                                                                  const Property& p,
-                                                                 std::istream& _is) noexcept
+                                                                 ByteReader& _in)
         {
             if (!p.is_list()) {
 
-                _is.read((char*)scratch, f.prop_stride);
+                _in.skip(f.prop_stride);
                 return f.prop_stride;
             }
 
@@ -263,21 +486,21 @@ parse_data(std::istream& is,
                              &listSize,
                              dummyCount,
                              f.list_stride,
-                             _is); // the list size (does not count for memory alloc)
+                             _in); // the list size (does not count for memory alloc)
             auto bytes_to_skip = f.prop_stride * listSize;
-            _is.ignore(bytes_to_skip);
+            _in.skip(bytes_to_skip);
 
             return bytes_to_skip;
         };
     }
     else {  // ascii
 
-        read = [this, &listSize, &dummyCount](PropertyLookup& f,
-                                              const Property& p,
-                                              uint8_t* dest,
-                                              size_t& destOffset,
-                                              const size_t destSize,
-                                              std::istream& _is)
+        read = [this, &listSize, &dummyCount, &check_list_size](PropertyLookup& f,
+                                                                const Property& p,
+                                                                uint8_t* dest,
+                                                                size_t& destOffset,
+                                                                const size_t destSize,
+                                                                ByteReader& _in)
         {
             if (!p.is_list())
 
@@ -286,7 +509,7 @@ parse_data(std::istream& is,
                                     dest + destOffset,
                                     destOffset,
                                     destSize,
-                                    _is);
+                                    _in);
 
             else {
                 dummyCount = 0;
@@ -295,7 +518,9 @@ parse_data(std::istream& is,
                                     &listSize,
                                     dummyCount,
                                     sizeof(listSize),
-                                    _is); // the list size
+                                    _in); // the list size
+                listSize = load_list_count(p.listType, &listSize);
+                check_list_size(p);
 
                 for (size_t i {}; i < listSize; ++i)
 
@@ -304,15 +529,14 @@ parse_data(std::istream& is,
                                         dest + destOffset,
                                         destOffset,
                                         destSize,
-                                        _is);
+                                        _in);
             }
         };
 
-        skip = [this, &listSize, &dummyCount, &skip_ascii_buffer](PropertyLookup& f,
-                                                                  const Property& p,
-                                                                  std::istream& _is) noexcept
+        skip = [this, &listSize, &dummyCount](PropertyLookup& f,
+                                              const Property& p,
+                                              ByteReader& _in)
         {
-            skip_ascii_buffer.clear();
             if (p.is_list()) {
 
                 dummyCount = 0;
@@ -321,41 +545,68 @@ parse_data(std::istream& is,
                                     &listSize,
                                     dummyCount,
                                     sizeof(listSize),
-                                    _is);  // the list size (does not count for memory alloc)
+                                    _in);  // the list size (does not count for memory alloc)
+                listSize = load_list_count(p.listType, &listSize);
 
                 for (size_t i {}; i < listSize; ++i)
-                    _is >> skip_ascii_buffer; // properties in list
+                    _in.token(); // properties in list
 
                 return listSize * f.prop_stride;
             }
-            _is >> skip_ascii_buffer;
+            _in.token();
             return f.prop_stride;
         };
     }
 
-    std::vector<std::vector<PropertyLookup>> element_property_lookup_table =
-        header.make_property_lookup_table();
+    if (lookupTable.empty())
+        lookupTable = header.make_property_lookup_table();
+
+    // Elements past the last one holding requested properties are of no
+    // interest: neither the counting pass nor the read needs to visit them.
+    const auto numElementsToVisit = static_cast<size_t>(
+        last_requested_element(lookupTable) + 1
+    );
 
     // This is the inner import loop
     for (size_t element_idx {};
          auto& element: header.elements) {
+        if (element_idx == numElementsToVisit)
+            break;
+
+        if (header.isBinary && !firstPass) {
+            if (const auto helper = whole_records(element, lookupTable[element_idx])) {
+                size_t at {};
+                read_property_binary(element.size * helper->stride,
+                                     helper->data->buffer.get(),
+                                     at,
+                                     helper->data->buffer.size_bytes(),
+                                     in);
+                element_idx++;
+                continue;
+            }
+            if (const auto bound = bound_records(element, lookupTable[element_idx])) {
+                decode_bound_records(*bound, element, in);
+                element_idx++;
+                continue;
+            }
+        }
+
         for (size_t count {}; count < element.size; ++count) {
 
             for (size_t property_idx {};
                  auto& property: element.properties) {
 
-                PropertyLookup& lookup =
-                    element_property_lookup_table[element_idx][property_idx];
+                PropertyLookup& lookup = lookupTable[element_idx][property_idx];
 
                 if (lookup.skip)
-                    skip(lookup, property, is);
+                    skip(lookup, property, in);
 
                 else {
 
                     ParsingHelper const* helper = lookup.helper;
                     if (firstPass) {
 
-                        helper->cursor->totalSizeBytes += skip(lookup, property, is);
+                        helper->cursor->totalSizeBytes += skip(lookup, property, in);
 
                         // These lines will be changed when tinyply supports
                         // variable length lists. We add it here so our header data structure
@@ -365,13 +616,31 @@ parse_data(std::istream& is,
                         if (property.listCount != listSize)
                             throw std::runtime_error("variable length lists are not supported yet.");
                     }
+                    else if (helper->stride) {  // a field of user records
+
+                        size_t at = count * helper->stride + helper->offset;
+                        maxListSize = helper->list_size_hint;
+                        read(lookup,
+                             property,
+                             helper->data->buffer.get(),
+                             at,
+                             helper->data->buffer.size_bytes(),
+                             in);
+                        maxListSize = std::numeric_limits<size_t>::max();
+
+                        if (property.is_list() && listSize != helper->list_size_hint)
+                            throw std::runtime_error(
+                                "list '" + property.name + "' is not of the "
+                                "requested length"
+                            );
+                    }
                     else
                         read(lookup,
                              property,
                              helper->data->buffer.get(),
                              helper->cursor->byteOffset,
                              helper->data->buffer.size_bytes(),  // destSize
-                             is);
+                             in);
                 }
 
                 property_idx++;
@@ -380,9 +649,129 @@ parse_data(std::istream& is,
         element_idx++;
     }
 
-    // Reset istream position to the start of the data
+    // Back to the start of the data
     if (firstPass)
-        is.seekg(start, is.beg);
+        in.seek(start);
+}
+
+std::vector<uint64_t> FileIn::
+element_offsets(ByteReader& in)
+{
+    if (!header.isBinary)
+        throw std::invalid_argument("element offsets are known for binary files only");
+
+    std::vector<uint64_t> offsets {in.tell()};
+
+    for (const auto& element: header.elements) {
+
+        size_t recordBytes {};
+        bool lists {};
+        for (const auto& p: element.properties) {
+            lists = lists || p.is_list();
+            recordBytes += p.is_list() ? 0 : types.at(p.scalarType).stride;
+        }
+
+        size_t expected = lists ? 0 : element.size * recordBytes;
+        size_t skipped = lists ? 0 : in.skip(expected);
+
+        for (size_t i {}; lists && i < element.size; ++i)
+            for (const auto& p: element.properties) {
+
+                const size_t stride = types.at(p.scalarType).stride;
+                size_t n {1};
+                if (p.is_list()) {
+                    uint32_t listSize {};
+                    const size_t listStride = types.at(p.listType).stride;
+                    if (in.read(&listSize, listStride) != listStride)
+                        throw std::runtime_error("unexpected EOF. malformed file?");
+                    if (header.isBigEndian)
+                        endian_reverse(p.listType, &listSize);
+                    n = load_list_count(p.listType, &listSize);
+                }
+                expected += n * stride;
+                skipped += in.skip(n * stride);
+            }
+
+        if (skipped != expected)
+            throw std::runtime_error("unexpected EOF. malformed file?");
+
+        offsets.push_back(in.tell());
+    }
+
+    return offsets;
+}
+
+ParsingHelper const* FileIn::
+whole_records(const Element& element,
+              const std::vector<PropertyLookup>& lookups) noexcept
+{
+    ParsingHelper const* first {};
+    size_t offset {};
+
+    for (size_t i {}; i < lookups.size(); ++i) {
+
+        const auto helper = lookups[i].helper;
+        if (lookups[i].skip || !helper->stride || element.properties[i].is_list() ||
+            helper->offset != offset || (first && helper->data != first->data))
+            return nullptr;
+
+        first = first ? first : helper;
+        offset += lookups[i].prop_stride;
+    }
+
+    return first && offset == first->stride ? first : nullptr;
+}
+
+FileIn::BoundRecords const* FileIn::
+bound_records(const Element& element,
+              const std::vector<PropertyLookup>& lookups) const noexcept
+{
+    for (const auto& bound: boundRecords) {
+
+        if (bound.element != element.name)
+            continue;
+
+        bool only {true};
+        for (const auto& lookup: lookups)
+            only = only && (lookup.skip || lookup.helper->data == bound.data);
+        if (only)
+            return &bound;
+    }
+    return nullptr;
+}
+
+void FileIn::
+decode_bound_records(const BoundRecords& records,
+                     const Element& element,
+                     ByteReader& in)
+{
+    const size_t recordBytes = records.layout.recordBytes;
+    uint8_t* dst = records.data->buffer.get();
+
+    for (size_t done {}; done < element.size; ) {
+
+        const auto src = in.records(recordBytes, element.size - done);
+        if (src.empty())
+            throw std::runtime_error("unexpected EOF. malformed file?");
+
+        const size_t n = src.size() / recordBytes;
+        records.decode(src.data(), n, dst + done * records.data->recordStride,
+                       records.layout);
+        done += n;
+    }
+}
+
+int64_t FileIn::
+last_requested_element(
+    const std::vector<std::vector<PropertyLookup>>& lookupTable
+) noexcept
+{
+    for (auto i = static_cast<int64_t>(lookupTable.size()) - 1; i >= 0; --i)
+        for (const auto& lookup: lookupTable[i])
+            if (!lookup.skip)
+                return i;
+
+    return -1;
 }
 
 size_t FileIn::
@@ -390,13 +779,13 @@ read_property_binary(const size_t stride,
                      void* dest,
                      size_t& destOffset,
                      const size_t destSize,
-                     std::istream& is)
+                     ByteReader& in)
 {
     if (destOffset + stride > destSize)
         throw std::runtime_error("unexpected EOF. malformed file?");
 
     destOffset += stride;
-    is.read(reinterpret_cast<char*>(dest), stride);
+    in.read(dest, stride);
 
     return stride;
 }
@@ -408,83 +797,135 @@ read_property_ascii(const Type t,
                     void* dest,
                     size_t& destOffset,
                     const size_t destSize,
-                    std::istream& is)
+                    ByteReader& in)
 {
     if (destOffset + stride > destSize)
         throw std::runtime_error("unexpected EOF. malformed file?");
 
-    types.at(t).read_ascii(is, dest);
+    types.at(t).read_ascii(in.token(), dest);
     destOffset += stride;
 
     return stride;
 }
 
+ReadPlan FileIn::
+plan() const
+{
+    ReadPlan plan;
+
+    for (const auto& element: header.elements)
+        for (const auto& property: element.properties) {
+
+            const auto helper = header.userData.find(element, property);
+            if (!helper)
+                continue;
+
+            auto group = std::find_if(
+                plan.groups.begin(), plan.groups.end(),
+                [&](const auto& g) { return g.data == helper->data; }
+            );
+            if (group == plan.groups.end()) {
+                plan.groups.push_back({element.name, {}, helper->data});
+                group = std::prev(plan.groups.end());
+            }
+            group->properties.push_back(property.name);
+
+            const size_t bytes = element.size *
+                                 types.at(property.scalarType).stride;
+            if (helper->stride)  // records of mixed types
+                group->bytes = element.size * helper->stride;
+            else if (!property.is_list())
+                group->bytes += bytes;
+            else if (helper->list_size_hint)
+                group->bytes += bytes * helper->list_size_hint;
+            else
+                group->exact = false;  // list lengths are known only after counting
+        }
+
+    for (const auto& group: plan.groups) {
+        plan.totalBytes += group.bytes;
+        plan.countingPass = plan.countingPass || !group.exact;
+    }
+
+    return plan;
+}
+
 void FileIn::
 read(std::istream& is)
 {
-    std::vector<std::shared_ptr<Data>> datas;
-    for (auto& [_, helper]: header.userData.get())
-        datas.push_back(helper.data);
-
-    // Discover if we can allocate up front without parsing the file twice
-    uint32_t list_hints {};
-    for (auto& d: datas)
-        for (const auto& [_, helper]: header.userData.get()) {
-            list_hints += helper.list_size_hint;
-            (void)d;
-        }
+    StreamSource source {is};
+    ByteReader in {source};
+    read(in);
+    in.release();  // the stream is left at the end of the data read
+}
 
-    // No list hints? Then we need to calculate how much memory to allocate
-    if (list_hints == 0)
-        parse_data(is, true);
-
-    // Count the number of properties (required for allocation)
-    // e.g. if we have properties x y and z requested, we ensure
-    // that their buffer points to the same Data
-    std::unordered_map<Data*, int32_t> unique_data_count;
-    for (auto& ptr: datas)
-        unique_data_count[ptr.get()] += 1;
-
-    // Since group-requested properties share the same cursor,
-    // we need to find unique cursors so we only allocate once
-    std::sort(datas.begin(), datas.end());
-    datas.erase(std::unique(datas.begin(), datas.end()), datas.end());
-
-    // We sorted by ptrs on Data, need to remap back onto its cursor in
-    // the userData table
-    for (auto& d: datas) {
-        for (auto& [_, helper]: header.userData.get()) {
-            if (helper.data == d && d->buffer.get() == nullptr) {
-
-                // If we didn't receive any list hints, it means we did two
-                // passes over the file to compute the total length of all
-                // (potentially) variable-length lists
-                if (list_hints == 0)
-                    d->buffer = Buffer{helper.cursor->totalSizeBytes};
-                else {
-                    // otherwise, we can allocate up front, skipping the first pass.
-                    const size_t list_size_multiplier =
-                        helper.data->isList ? helper.list_size_hint : 1;
+void FileIn::
+read(ByteSource& source)
+{
+    // The header was parsed out of a source bound to `input`, which must be
+    // this one; otherwise the data start at the position of the source.
+    ByteReader in = std::exchange(input, ByteReader {});
+    if (!in.bound())
+        in = ByteReader {source};
+    else if (!in.reads_from(source))
+        throw std::invalid_argument(
+            "the data must be read from the source the header was parsed from"
+        );
+    read(in);
+    in.release();  // the source is left at the end of the data read
+}
 
-                    auto bytes_per_property = helper.data->count *
-                                              types.at(helper.data->t).stride *
-                                              list_size_multiplier;
-                    bytes_per_property *= unique_data_count[d.get()];
+void FileIn::
+read(ByteReader& in)
+{
+    const auto readPlan = plan();
 
-                    d->buffer = Buffer{bytes_per_property};
+    // The data may be read into repeatedly, e.g. for a sequence of files.
+    for (auto& [_, helper]: header.userData.get())
+        *helper.cursor = DataCursor {};
+    for (const auto& group: readPlan.groups)
+        group.data->count = header.find_element(group.element)->size;
+
+    // Lists without a size hint make the buffer sizes unknown: we then need
+    // a first pass over the file to calculate how much memory to allocate.
+    if (readPlan.countingPass)
+        parse_data(in, true);
+
+    // Group-requested properties share the same Data and cursor,
+    // so each group is allocated only once.
+    for (const auto& group: readPlan.groups) {
+
+        size_t bytes = group.bytes;
+        if (!group.exact)
+            for (const auto& [_, helper]: header.userData.get())
+                if (helper.data == group.data) {
+                    bytes = helper.cursor->totalSizeBytes;
+                    break;
                 }
 
-            }
-        }
+        group.data->buffer.resize(bytes);
     }
 
     // Populate the data
-    parse_data(is, false);
+    parse_data(in, false);
 
     // In-place big-endian to little-endian swapping if required
-    if (header.isBigEndian)
-        for (auto& d: datas)
-            d->endian_reverse();
+    if (header.isBigEndian) {
+        for (const auto& group: readPlan.groups)
+            group.data->endian_reverse();
+
+        // Records are swapped field by field.
+        for (const auto& element: header.elements)
+            for (const auto& property: element.properties) {
+                const auto helper = header.userData.find(element, property);
+                if (helper && helper->stride)
+                    swap_strided(helper->data->buffer.get() + helper->offset,
+                                 helper->stride,
+                                 element.size,
+                                 property.is_list() ? helper->list_size_hint : 1,
+                                 types.at(property.scalarType).stride);
+            }
+    }
 }
 
 
@@ -0,0 +1,192 @@
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TINYPLY_IMPL_FILE_LOADER_H
+#define TINYPLY_IMPL_FILE_LOADER_H
+
+#include "impl/byte_source.h"
+#include "impl/data_buffer.h"
+#include "impl/file_in.h"
+
+#include <algorithm>  // find_if
+#include <atomic>  // atomic_thread_fence
+#include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace tinyply::impl {
+
+    /**
+     * Properties to be read from an element,
+     * as in `request_properties_from_element(...)`.
+     */
+    struct Request {
+
+        std::string element;
+        std::vector<std::string> properties;
+        uint32_t listSizeHint {};
+    };
+
+
+    /**
+     * Reads a sequence of files one after another with one reader, keeping
+     * the memory used for the file contents, the parsing state and, once
+     * released by the caller, the Data buffers of the previous files for
+     * the next one. The caller may release the data on any thread, but must
+     * not touch it after the release.
+     */
+    struct FileLoader {
+
+        /// Files whose data is kept for recycling, so that it is found
+        /// released even if the next file is loaded before the caller is
+        /// done with the last one.
+        static constexpr size_t recycledFiles {2};
+
+        std::vector<uint8_t> bytes;  ///< contents of the current file
+        FileIn file;                 ///< reset from file to file
+
+        /// Data of the previous files, per request, the latest last.
+        std::vector<std::vector<std::shared_ptr<Data>>> recycled;
+
+        /// Of the last file loaded: the requested elements and properties
+        /// it lacks, and the requests it could not satisfy otherwise.
+        std::vector<std::string> skipped;
+
+        /**
+         * Reads the requested properties from the file at `path`.
+         * \returns Data per request, in the order of `requests`; a request
+         * that the file cannot satisfy leaves its entry empty, and is
+         * reported in `skipped`. Properties the file lacks are left out of
+         * their request and reported there as well.
+         */
+        std::vector<std::shared_ptr<Data>> load(
+            const std::filesystem::path& path,
+            const std::vector<Request>& requests
+        );
+
+        void read_file(const std::filesystem::path& path);
+    };
+
+}  // namespace tinyply::impl
+
+
+// IMPLEMENTATION ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+#ifdef TINYPLY_AS_LIBRARY
+
+namespace tinyply::impl {
+
+void FileLoader::
+read_file(const std::filesystem::path& path)
+{
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+    if (ifs.fail())
+        throw std::runtime_error("failed to open " + path.string());
+
+    bytes.resize(static_cast<size_t>(ifs.tellg()));
+    ifs.seekg(0, std::ios::beg);
+    if (!ifs.read(reinterpret_cast<char*>(bytes.data()), bytes.size()))
+        throw std::runtime_error("failed to read " + path.string());
+}
+
+std::vector<std::shared_ptr<Data>> FileLoader::
+load(const std::filesystem::path& path,
+     const std::vector<Request>& requests)
+{
+    // Before looking at the use of the recycled data, which the requests
+    // of the previous file hold as well.
+    file.reset();
+    skipped.clear();
+
+    read_file(path);
+    MemorySource source {bytes};
+    ByteReader in {source};
+
+    if (!file.header.parse(in))
+        throw std::runtime_error("malformed header in " + path.string());
+
+    recycled.resize(requests.size());
+    std::vector<std::shared_ptr<Data>> data(requests.size());
+
+    for (size_t i {}; i < requests.size(); ++i) {
+
+        const auto& request = requests[i];
+        const auto element = file.header.find_element(request.element);
+        if (!element) {
+            skipped.push_back("element " + request.element + " not found");
+            continue;
+        }
+        std::vector<std::string> properties;
+        for (const auto& name: request.properties)
+            if (element->contains(name))
+                properties.push_back(name);
+            else
+                skipped.push_back("property " + name + " not found in the element " +
+                                  request.element);
+        if (properties.empty())
+            continue;
+
+        // Only the loader holds the previous data: the caller is done with it.
+        // The release of the last other copy decrements the count with release
+        // semantics; the fence orders its writes to the buffer before ours.
+        auto& previous = recycled[i];
+        const auto free = std::ranges::find_if(previous, [](const auto& d) {
+            return d.use_count() == 1;
+        });
+        const bool reuse = free != previous.end();
+        if (reuse)
+            std::atomic_thread_fence(std::memory_order_acquire);
+        try {
+            data[i] = file.request_properties_from_element(
+                *element,
+                properties,
+                request.listSizeHint,
+                reuse ? std::move(*free) : nullptr
+            );
+        }
+        catch (const std::invalid_argument& e) {
+            skipped.push_back(e.what());
+        }
+        if (reuse)
+            previous.erase(free);
+    }
+
+    file.read(in);
+    for (size_t i {}; i < requests.size(); ++i) {
+        auto& previous = recycled[i];
+        if (data[i])
+            previous.push_back(data[i]);
+        if (previous.size() > recycledFiles)
+            previous.erase(previous.begin());
+    }
+
+    return data;
+}
+
+}  // namespace tinyply::impl
+
+#endif  // TINYPLY_AS_LIBRARY
+#endif  // TINYPLY_IMPL_FILE_LOADER_H
@@ -24,31 +24,178 @@
 #ifndef TINYPLY_IMPL_FILE_OUT_H
 #define TINYPLY_IMPL_FILE_OUT_H
 
+#include "impl/byte_source.h"
+#include "impl/chunk_writer.h"
 #include "impl/data_buffer.h"
+#include "impl/file_in.h"
 #include "impl/header.h"
+#include "impl/interleave.h"
+#include "impl/misc.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <charconv>  // to_chars
 #include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
 #include <cstring>  // memcpy
 #include <filesystem>
 #include <fstream>
 #include <functional>  // function
+#include <future>
 #include <iostream>
 #include <memory>
 #include <set>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>  // error_code
+#include <thread>
+#include <utility>  // pair
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>  // open, posix_fallocate
+#include <sys/mman.h>  // mmap, msync, munmap
+#include <unistd.h>  // ftruncate, close, write
+#endif
 
 namespace tinyply::impl {
 
+/**
+ * Source of the values of a property, resolved once per write.
+ */
+struct FieldSource {
+
+    const Property* property {};
+    uint8_t const* data {};      ///< value in the first record
+    size_t stride {};            ///< bytes between consecutive records
+    size_t count {1};            ///< values per record, unless variable
+    size_t const* offsets {};    ///< first value of each variable-length list
+    size_t bytes {};             ///< value bytes per record, unless variable
+    size_t listStride {};        ///< bytes of the list count, zero if not a list
+    const Info* info {};         ///< of the value type in the source
+    const Info* out {};          ///< of the value type in the file
+    Converter convert {};        ///< from `info` to `out`, if they differ
+    double scale {1};            ///< applied by `convert`
+
+    /**
+     * Values of the record `i` and their number.
+     */
+    std::pair<uint8_t const*, size_t> values(const size_t i) const noexcept
+    {
+        if (offsets)
+            return {data + offsets[i] * info->stride, offsets[i+1] - offsets[i]};
+
+        return {data + i * stride, count};
+    }
+
+    /**
+     * Copies `n` values from `src` to `dst` in the file type.
+     * \returns the end of the values written.
+     */
+    uint8_t* emit(uint8_t* dst,
+                  uint8_t const* src,
+                  const size_t n) const noexcept
+    {
+        if (convert)
+            convert(dst, 0, src, 0, 1, n, scale);
+        else
+            std::memcpy(dst, src, n * info->stride);
+
+        return dst + n * out->stride;
+    }
+};
+
+/**
+ * Flat copy program for the records of an element.
+ */
+struct ElementLayout {
+
+    const Element* element {};
+    std::vector<FieldSource> fields;
+    size_t recordBytes {};  ///< binary record size, excluding variable lists
+    bool contiguous {};     ///< source records are laid out as in the file
+    bool fixed {};          ///< binary records are all `recordBytes` long
+    bool swap {};           ///< binary values are written big-endian
+};
+
+
+/**
+ * Output of `FileOut::rewrite`: bytes written through, and ranges of the
+ * source file copied by the kernel where it can, from memory otherwise.
+ */
+class RewriteSink {
+
+    std::span<const uint8_t> source;  ///< the whole source file
+#if defined(__unix__) || defined(__APPLE__)
+    int fd {-1};
+    int sourceFd {-1};
+#else
+    std::ofstream os;
+#endif
+
+public:
+
+    RewriteSink(const std::filesystem::path& from,
+                std::span<const uint8_t> source,
+                const std::filesystem::path& to);
+    ~RewriteSink();
+
+    RewriteSink(const RewriteSink&) = delete;
+    RewriteSink& operator=(const RewriteSink&) = delete;
+
+    void write(const uint8_t* data,
+               size_t n);
+
+    /// Copies `n` bytes of the source from offset `at`.
+    void copy(uint64_t at,
+              uint64_t n);
+};
+
+
 struct FileOut {
 
     using PropertyLookup = Header::PropertyLookup;
 
     Header header;
 
+    size_t numThreads {1};  ///< formatting ascii or filling mapped binary output
+    bool bigEndian {};      ///< byte order of binary output
+    size_t queuedChunks {}; ///< for a background writer thread, if nonzero
+
+    /// Ascii records are formatted in blocks of this size, one per thread.
+    static constexpr size_t recordsPerBlock {size_t(1) << 16};
+
     void write(std::ostream& os,
                bool asBinary);
     void write(const std::filesystem::path& p,
                bool asBinary);
 
+    /**
+     * Exact size of the binary output in bytes, header included, e.g. to
+     * allocate the buffer for `write_binary(std::span<std::byte>)` once.
+     */
+    size_t binary_size();
+
+    /**
+     * Writes binary output into `dst`, returning the number of bytes
+     * written; throws if `dst` is smaller than `binary_size()`.
+     */
+    size_t write_binary(std::span<std::byte> dst);
+
+    /**
+     * Writes the output into memory owned by the caller. Binary output is
+     * allocated once at its exact size; ascii output grows as it is formatted.
+     */
+    std::vector<uint8_t> write_to_memory(bool asBinary);
+
+    /**
+     * Writes `to` as the binary file `from` with its elements of the
+     * names of those added here replaced by them; see `Writer::rewrite`.
+     */
+    void rewrite(const std::filesystem::path& from,
+                 const std::filesystem::path& to);
+
     constexpr Element& add_element(const std::string& elementName) noexcept;
 
     void add_properties_to_element(
@@ -71,17 +218,107 @@ struct FileOut {
         const size_t listCount
     );
 
-    void write_ascii(std::ostream& os) noexcept;
-    void write_binary(std::ostream& os) noexcept;
-
-    void write_scalar_ascii(Type t,
-                            std::ostream& os,
-                            uint8_t const* src,
-                            size_t& srcOffset) const;
-    void write_scalar_binary(std::ostream& os,
-                             uint8_t const* src,
-                             size_t& srcOffset,
-                             const size_t stride) const noexcept;
+    void add_properties_to_element(
+        const std::string& elementKey,
+        const std::vector<std::string>& propertyKeys,
+        const Type type,
+        const size_t count,
+        uint8_t const* data,
+        const size_t stride,
+        const std::vector<size_t>& offsets,
+        const Type listType,
+        const size_t listCount
+    );
+
+    void add_record_to_element(
+        const std::string& elementKey,
+        const size_t count,
+        uint8_t const* data,
+        const size_t stride,
+        const std::vector<Field>& fields
+    );
+
+    void add_properties_to_element(
+        const std::string& elementKey,
+        const std::vector<std::string>& propertyKeys,
+        const Type type,
+        const size_t count,
+        const std::vector<uint8_t const*>& data,
+        const Type listType,
+        const size_t listCount
+    );
+
+    void set_output_type(
+        const std::string& elementKey,
+        const std::vector<std::string>& propertyKeys,
+        const Type type,
+        const double scale
+    );
+
+    void add_list_property_to_element(
+        const std::string& elementKey,
+        const std::string& propertyKey,
+        const Type type,
+        const size_t count,
+        uint8_t const* values,
+        const Type listType,
+        size_t const* offsets
+    );
+
+    void write_ascii(std::ostream& os);
+    void write_binary(std::ostream& os);
+
+    /**
+     * Writes binary output through a memory map of the file, sized
+     * beforehand, with the threads filling disjoint ranges of records.
+     * Returns false if the file cannot be mapped or its space reserved,
+     * e.g. on systems without mmap or posix_fallocate, leaving the
+     * stream-based `write_binary` to it. Throws if the output cannot be
+     * synced to disk, leaving the file at `p` as it was.
+     */
+    bool write_binary_mapped(const std::filesystem::path& p);
+
+    std::string binary_header();
+
+    /**
+     * Fills `dst` with the binary records of all elements, split between
+     * the threads. `dst` must hold the sum of their `binary_size`.
+     */
+    void fill_binary(uint8_t* dst,
+                     const std::vector<ElementLayout>& layouts) const;
+
+    static size_t binary_size(const ElementLayout& layout);
+
+    static void swap_binary_records(uint8_t* dst,
+                                    const ElementLayout& layout,
+                                    size_t n) noexcept;
+
+    static uint8_t* copy_binary_records(uint8_t* dst,
+                                        const ElementLayout& layout,
+                                        size_t begin,
+                                        size_t end) noexcept;
+
+    std::vector<ElementLayout> make_element_layouts() const;
+
+    static void check_list_lengths(const FieldSource& f,
+                                   size_t count);
+
+    static void write_binary_records(ChunkWriter& out,
+                                     const ElementLayout& layout,
+                                     size_t begin,
+                                     size_t end);
+
+    static void write_ascii_values(ChunkWriter& out,
+                                   const FieldSource& f,
+                                   uint8_t const* src,
+                                   size_t n);
+
+    static void write_ascii_records(ChunkWriter& out,
+                                    const ElementLayout& layout,
+                                    size_t begin,
+                                    size_t end);
+
+    void write_ascii_elements(ChunkWriter& out);
 };
 
 }  // namespace tinyply::impl
@@ -107,11 +344,18 @@ add_properties_to_element(Element& element,
                           const Type listType,
                           const size_t listCount)
 {
+    // Properties of a group are interleaved in the source records.
+    const size_t valueBytes = types.at(type).stride *
+                              (listType == Type::INVALID ? 1 : listCount);
+
     ParsingHelper helper;
     helper.data = std::make_shared<Data>(type, Buffer(data), count, false);
     helper.cursor = std::make_shared<DataCursor>();
-    for (auto& key: propertyKeys)
+    helper.stride = valueBytes * propertyKeys.size();
+    for (auto& key: propertyKeys) {
         header.userData.insert(element.name, key, std::move(helper));
+        helper.offset += valueBytes;
+    }
 
     element.create_properties(propertyKeys, type, listType, listCount);
 }
@@ -125,48 +369,105 @@ add_properties_to_element(const std::string& elementKey,
                           const Type listType,
                           const size_t listCount)
 {
-    ParsingHelper helper;
-    helper.data = std::make_shared<Data>(type, Buffer(data), count, false);
-    helper.cursor = std::make_shared<DataCursor>();
-    for (auto& key: propertyKeys)
-        header.userData.insert(elementKey, key, std::move(helper));
+    // Tightly packed records of just these properties.
+    const size_t valueBytes = types.at(type).stride *
+                              (listType == Type::INVALID ? 1 : listCount);
 
-    auto e = header.find_element(elementKey);
-    if (!e)
-        e = &header.elements.emplace_back(elementKey, count);
-    e->create_properties(propertyKeys, type, listType, listCount);
+    std::vector<size_t> offsets(propertyKeys.size());
+    for (size_t k {}; k < offsets.size(); ++k)
+        offsets[k] = k * valueBytes;
+
+    add_properties_to_element(elementKey, propertyKeys, type, count, data,
+                              valueBytes * propertyKeys.size(), offsets,
+                              listType, listCount);
 }
 
+// Records of `stride` bytes holding the property `k` at `offsets[k]`.
+void FileOut::
+add_properties_to_element(const std::string& elementKey,
+                          const std::vector<std::string>& propertyKeys,
+                          const Type type,
+                          const size_t count,
+                          uint8_t const* data,
+                          const size_t stride,
+                          const std::vector<size_t>& offsets,
+                          const Type listType,
+                          const size_t listCount)
+{
+    if (offsets.size() != propertyKeys.size())
+        throw std::invalid_argument("one offset per property is needed");
+
+    std::vector<Field> fields;
+    for (size_t k {}; k < propertyKeys.size(); ++k)
+        fields.emplace_back(propertyKeys[k], type, offsets[k], listType, listCount);
 
+    add_record_to_element(elementKey, count, data, stride, fields);
+}
+
+// Records of `stride` bytes, each field with its own type and offset.
 void FileOut::
-write_scalar_ascii(const Type t,
-                   std::ostream& os,
-                   const uint8_t* src,
-                   size_t& srcOffset) const
+add_record_to_element(const std::string& elementKey,
+                      const size_t count,
+                      uint8_t const* data,
+                      const size_t stride,
+                      const std::vector<Field>& fields)
 {
-    srcOffset += types.at(t).write_ascii(os, src);
-    os << " ";
+    for (const auto& f: fields)
+        if (f.offset + f.bytes() > stride)
+            throw std::invalid_argument("property '" + f.name +
+                                        "' exceeds the record stride");
+
+    auto e = header.find_element(elementKey);
+    if (!e)
+        e = &header.elements.emplace_back(elementKey, count);
+
+    for (const auto& f: fields) {
+        ParsingHelper helper;
+        helper.data = std::make_shared<Data>(f.type, Buffer(data), count, false);
+        helper.cursor = std::make_shared<DataCursor>();
+        helper.offset = f.offset;
+        helper.stride = stride;
+        header.userData.insert(elementKey, f.name, std::move(helper));
+        e->create_properties({f.name}, f.type, f.listType, f.listCount);
+    }
 }
 
+// One source array per property.
 void FileOut::
-write_scalar_binary(std::ostream& os,
-                    uint8_t const* src,
-                    size_t& srcOffset,
-                    const size_t stride) const noexcept
+add_properties_to_element(const std::string& elementKey,
+                          const std::vector<std::string>& propertyKeys,
+                          const Type type,
+                          const size_t count,
+                          const std::vector<uint8_t const*>& data,
+                          const Type listType,
+                          const size_t listCount)
 {
-    os.write(reinterpret_cast<const char*>(src), stride);
-    srcOffset += stride;
+    if (data.size() != propertyKeys.size())
+        throw std::invalid_argument("one data array per property is needed");
+
+    const size_t valueBytes = types.at(type).stride *
+                              (listType == Type::INVALID ? 1 : listCount);
+
+    for (size_t k {}; k < propertyKeys.size(); ++k) {
+        ParsingHelper helper;
+        helper.data = std::make_shared<Data>(type, Buffer(data[k]), count, false);
+        helper.cursor = std::make_shared<DataCursor>();
+        helper.stride = valueBytes;
+        header.userData.insert(elementKey, propertyKeys[k], std::move(helper));
+    }
+
+    auto e = header.find_element(elementKey);
+    if (!e)
+        e = &header.elements.emplace_back(elementKey, count);
+    e->create_properties(propertyKeys, type, listType, listCount);
 }
 
 void FileOut::
 write(std::ostream& os,
       const bool asBinary)
 {
-    for (auto& d: header.userData.get())
-        d.second.cursor->byteOffset = 0;
-
     header.isBinary = asBinary;
-    header.isBigEndian = false;
+    header.isBigEndian = asBinary && bigEndian;
     asBinary
         ? write_binary(os)
         : write_ascii(os);
@@ -176,112 +477,730 @@ void FileOut::
 write(const std::filesystem::path& p,
       const bool asBinary)
 {
-    const auto a = asBinary ? std::ios::out
-                            : std::ios::out | std::ios::binary;
+    std::cout << "writing to " << p.string() << std::endl;
+
+    // Page faults make the map slower than the stream for a single thread.
+    if (asBinary && numThreads != 1 && write_binary_mapped(p))
+        return;
+
+    const auto a = asBinary ? std::ios::out | std::ios::binary
+                            : std::ios::out;
     std::ofstream ost(p, a);
     if (ost.fail())
         throw std::runtime_error("failed to open " + p.string());
 
-    std::cout << "writing to " << p.string() << std::endl;
-
     write(ost, asBinary);
 }
 
+std::vector<ElementLayout> FileOut::
+make_element_layouts() const
+{
+    std::vector<ElementLayout> layouts;
+
+    for (const auto& e: header.elements) {
+
+        auto& layout = layouts.emplace_back(&e);
+        layout.contiguous = true;
+        layout.fixed = true;
+        layout.swap = header.isBinary && header.isBigEndian;
+
+        for (const auto& p: e.properties) {
+
+            const auto helper = header.userData.find(e, p);
+            if (!helper)
+                continue;
+
+            FieldSource f {&p};
+            f.data = helper->data->buffer.get() + helper->offset;
+            f.stride = helper->stride;
+            f.info = &types.at(helper->data->t);
+            f.out = &types.at(p.scalarType);
+            if (f.info != f.out || helper->scale != 1) {
+                f.convert = converter(f.info->t, f.out->t);
+                f.scale = helper->scale;
+            }
+            if (p.is_list()) {
+                f.count = p.listCount;
+                f.offsets = helper->listOffsets;
+                f.listStride = types.at(p.listType).stride;
+                check_list_lengths(f, e.size);
+            }
+            f.bytes = f.offsets ? 0 : f.count * f.out->stride;
+
+            // Contiguous if all the values come from one array of records
+            // containing just these properties, in the order of the file.
+            const auto& first = layout.fields.empty() ? f
+                                                      : layout.fields.front();
+            layout.contiguous = layout.contiguous &&
+                                !p.is_list() && !f.convert &&
+                                f.data == first.data + layout.recordBytes;
+
+            layout.fixed = layout.fixed && !f.offsets;
+            layout.recordBytes += f.listStride + f.bytes;
+            layout.fields.push_back(f);
+        }
+
+        layout.contiguous = layout.contiguous && !layout.fields.empty();
+        for (const auto& f: layout.fields)
+            layout.contiguous = layout.contiguous &&
+                                f.stride == layout.recordBytes;
+    }
+
+    return layouts;
+}
+
+// The lengths of the lists must fit into the type of the list count:
+// the fixed length, or that of each of the `count` variable lists.
 void FileOut::
-write_binary(std::ostream& os) noexcept
+check_list_lengths(const FieldSource& f,
+                   const size_t count)
+{
+    size_t longest = f.offsets ? 0 : f.count;
+    if (f.offsets)
+        for (size_t i {}; i < count; ++i)
+            longest = std::max(longest, f.offsets[i+1] - f.offsets[i]);
+
+    // Signed counts keep their top bit clear.
+    const auto t = f.property->listType;
+    const bool isSigned = t == Type::INT8 || t == Type::INT16 || t == Type::INT32;
+    const size_t bits = 8 * f.listStride - isSigned;
+
+    if (bits < 8 * sizeof(size_t) && longest >> bits)
+        throw std::runtime_error(
+            "a list of '" + f.property->name + "' is too long for its count type"
+        );
+}
+
+void FileOut::
+write_binary(std::ostream& os)
 {
     header.isBinary = true;
     header.write(os);
 
-    uint8_t listSize[4] = {}; //{ 0, 0, 0, 0 };
-    size_t dummyCount {};
+    ChunkWriter out {os, ChunkWriter::defaultChunkSize, queuedChunks};
+
+    for (const auto& layout: make_element_layouts()) {
+
+        const size_t count = layout.element->size;
+
+        if (layout.contiguous && !layout.swap) {
+            out.append(layout.fields.front().data, count * layout.recordBytes);
+            continue;
+        }
+
+        write_binary_records(out, layout, 0, count);
+    }
+
+    out.flush();
+}
+
+void FileOut::
+write_binary_records(ChunkWriter& out,
+                     const ElementLayout& layout,
+                     const size_t begin,
+                     const size_t end)
+{
+    if (layout.fixed) {
+        // Interleaved a chunk of records at a time.
+        const size_t perBlock = std::max<size_t>(
+            1, ChunkWriter::defaultChunkSize / std::max<size_t>(1, layout.recordBytes)
+        );
+        for (size_t b = begin; b < end; b += perBlock) {
+            const size_t e = std::min(b + perBlock, end);
+            const size_t bytes = (e - b) * layout.recordBytes;
+            copy_binary_records(out.reserve(bytes), layout, b, e);
+            out.commit(bytes);
+        }
+        return;
+    }
+
+    for (size_t i = begin; i < end; ++i)
+        for (const auto& f: layout.fields) {
+
+            const auto [src, n] = f.values(i);
+            const size_t bytes = n * f.out->stride;
+            uint8_t* dst = out.reserve(f.listStride + bytes);
+
+            if (f.listStride)
+                store_list_count(f.property->listType, static_cast<uint32_t>(n), dst);
+            f.emit(dst + f.listStride, src, n);
+            if (layout.swap) {
+                swap_strided(dst, 0, 1, 1, f.listStride);
+                swap_strided(dst + f.listStride, 0, 1, n, f.out->stride);
+            }
+            out.commit(f.listStride + bytes);
+        }
+}
 
-    auto element_property_lookup = header.make_property_lookup_table();
+// Bytes of the element in binary output.
+size_t FileOut::
+binary_size(const ElementLayout& layout)
+{
+    const size_t count = layout.element->size;
 
-    for (size_t element_idx {};
-         auto& e: header.elements) {
-        for (size_t i {}; i < e.size; ++i) {
-            for (size_t property_index {};
-                 auto& p : e.properties) {
+    size_t bytes = count * layout.recordBytes;
+    for (const auto& f: layout.fields)
+        if (f.offsets)
+            bytes += (f.offsets[count] - f.offsets[0]) * f.out->stride;
 
-                auto& f = element_property_lookup[element_idx][property_index];
-                auto* helper = f.helper;
+    return bytes;
+}
 
-                if (f.skip || helper == nullptr)
-                    continue;
+uint8_t* FileOut::
+copy_binary_records(uint8_t* dst,
+                    const ElementLayout& layout,
+                    const size_t begin,
+                    const size_t end) noexcept
+{
+    if (begin == end)
+        return dst;
 
-                if (p.is_list()) {
+    if (layout.contiguous) {
+        const size_t bytes = (end - begin) * layout.recordBytes;
+        std::memcpy(dst, layout.fields.front().data + begin * layout.recordBytes,
+                    bytes);
+        if (layout.swap)
+            swap_binary_records(dst, layout, end - begin);
+        return dst + bytes;
+    }
 
-                    std::memcpy(listSize, &p.listCount, sizeof(uint32_t));
-                    write_scalar_binary(os,
-                                        listSize,
-                                        dummyCount,
-                                        f.list_stride);
-                    write_scalar_binary(
-                        os,
-                        helper->data->buffer.get() + helper->cursor->byteOffset,
-                        helper->cursor->byteOffset,
-                        f.prop_stride * p.listCount
-                    );
+    if (layout.fixed) {
+        // Each property is copied into its place in all the records.
+        const size_t n = end - begin;
+        size_t at {};
+        for (const auto& f: layout.fields) {
+            if (f.listStride) {
+                uint8_t count[sizeof(uint32_t)];
+                store_list_count(f.property->listType, static_cast<uint32_t>(f.count), count);
+                switch (f.listStride) {  // list counts are of 1, 2 or 4 bytes
+                    case 1:  copy_strided<1>(dst + at, layout.recordBytes, count, 0, n); break;
+                    case 2:  copy_strided<2>(dst + at, layout.recordBytes, count, 0, n); break;
+                    default: copy_strided<4>(dst + at, layout.recordBytes, count, 0, n);
                 }
-                else
-                    write_scalar_binary(
-                        os,
-                        helper->data->buffer.get() + helper->cursor->byteOffset,
-                        helper->cursor->byteOffset,
-                        f.prop_stride
-                    );
-                property_index++;
+                at += f.listStride;
             }
+            if (f.convert)
+                f.convert(dst + at, layout.recordBytes,
+                          f.data + begin * f.stride, f.stride, n, f.count,
+                          f.scale);
+            else
+                copy_strided(dst + at, layout.recordBytes,
+                             f.data + begin * f.stride, f.stride, n, f.bytes);
+            at += f.bytes;
         }
-        element_idx++;
+        if (layout.swap)
+            swap_binary_records(dst, layout, n);
+        return dst + n * layout.recordBytes;
     }
+
+    for (size_t i = begin; i < end; ++i)
+        for (const auto& f: layout.fields) {
+
+            const auto [src, n] = f.values(i);
+            if (f.listStride) {
+                store_list_count(f.property->listType, static_cast<uint32_t>(n), dst);
+                if (layout.swap)
+                    swap_strided(dst, 0, 1, 1, f.listStride);
+                dst += f.listStride;
+            }
+            uint8_t* const values = dst;
+            dst = f.emit(dst, src, n);
+            if (layout.swap)
+                swap_strided(values, 0, 1, n, f.out->stride);
+        }
+
+    return dst;
 }
 
+// Reverses the byte order of the values in `n` records of a fixed layout,
+// while the block is still in cache.
 void FileOut::
-write_ascii(std::ostream& os) noexcept
+swap_binary_records(uint8_t* dst,
+                    const ElementLayout& layout,
+                    const size_t n) noexcept
+{
+    for (const auto& f: layout.fields) {
+        if (f.listStride) {
+            swap_strided(dst, layout.recordBytes, n, 1, f.listStride);
+            dst += f.listStride;
+        }
+        swap_strided(dst, layout.recordBytes, n, f.count, f.out->stride);
+        dst += f.bytes;
+    }
+}
+
+RewriteSink::
+RewriteSink(const std::filesystem::path& from,
+            std::span<const uint8_t> source,
+            const std::filesystem::path& to)
+    : source {source}
+{
+#if defined(__unix__) || defined(__APPLE__)
+    fd = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("failed to open " + to.string());
+    sourceFd = ::open(from.c_str(), O_RDONLY);  // optional, for the kernel copies
+#else
+    (void)from;
+    os.open(to, std::ios::binary);
+    if (os.fail())
+        throw std::runtime_error("failed to open " + to.string());
+#endif
+}
+
+RewriteSink::
+~RewriteSink()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if (sourceFd >= 0)
+        ::close(sourceFd);
+    ::close(fd);
+#endif
+}
+
+void RewriteSink::
+write(const uint8_t* data,
+      size_t n)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    while (n) {
+        const auto k = ::write(fd, data, n);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            throw std::runtime_error("failed to write the output");
+        data += k;
+        n -= static_cast<size_t>(k);
+    }
+#else
+    os.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(n));
+    if (os.fail())
+        throw std::runtime_error("failed to write the output");
+#endif
+}
+
+void RewriteSink::
+copy(uint64_t at,
+     uint64_t n)
+{
+#if defined(__linux__)
+    // In the kernel, possibly sharing the blocks; the file offset of the
+    // output moves on as with `write`.
+    auto from = static_cast<off_t>(at);
+    while (n && sourceFd >= 0) {
+        const auto k = ::copy_file_range(sourceFd, &from, fd, nullptr, n, 0);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            break;  // e.g. unsupported between these files: copy the rest below
+        n -= static_cast<uint64_t>(k);
+    }
+    at = static_cast<uint64_t>(from);
+#endif
+    write(source.data() + at, static_cast<size_t>(n));
+}
+
+// The header of binary output, in the byte order asked for.
+std::string FileOut::
+binary_header()
+{
+    header.isBinary = true;
+    header.isBigEndian = bigEndian;
+    std::ostringstream text;
+    header.write(text);
+    return text.str();
+}
+
+size_t FileOut::
+binary_size()
+{
+    size_t total = binary_header().size();
+    for (const auto& layout: make_element_layouts())
+        total += binary_size(layout);
+
+    return total;
+}
+
+void FileOut::
+fill_binary(uint8_t* dst,
+            const std::vector<ElementLayout>& layouts) const
+{
+    const size_t n = numThreads ? numThreads
+                                : std::max(1u, std::thread::hardware_concurrency());
+
+    for (const auto& layout: layouts) {
+
+        const size_t count = layout.element->size;
+
+        // Records of fixed size start at known offsets and are split
+        // between the threads; variable-length lists are copied in one go.
+        const size_t blocks = layout.fixed ? std::min(n, 1 + count / recordsPerBlock)
+                                           : 1;
+        const size_t perBlock = (count + blocks - 1) / blocks;
+
+        std::vector<std::future<void>> tasks;
+        for (size_t b = 1; b < blocks; ++b) {
+            const size_t begin = std::min(b * perBlock, count);
+            const size_t end = std::min(begin + perBlock, count);
+            tasks.push_back(std::async(std::launch::async,
+                                       [dst, &layout, begin, end] {
+                copy_binary_records(dst + begin * layout.recordBytes,
+                                    layout, begin, end);
+            }));
+        }
+        copy_binary_records(dst, layout, 0, std::min(perBlock, count));
+
+        for (auto& t: tasks)
+            t.get();
+        dst += binary_size(layout);
+    }
+}
+
+size_t FileOut::
+write_binary(std::span<std::byte> dst)
+{
+    const auto head = binary_header();
+    const auto layouts = make_element_layouts();
+    size_t total = head.size();
+    for (const auto& layout: layouts)
+        total += binary_size(layout);
+
+    if (dst.size() < total)
+        throw std::length_error("the output needs " + std::to_string(total) +
+                                " bytes, the buffer holds " +
+                                std::to_string(dst.size()));
+
+    auto* out = reinterpret_cast<uint8_t*>(dst.data());
+    std::memcpy(out, head.data(), head.size());
+    fill_binary(out + head.size(), layouts);
+
+    return total;
+}
+
+std::vector<uint8_t> FileOut::
+write_to_memory(const bool asBinary)
+{
+    if (asBinary) {
+        std::vector<uint8_t> bytes(binary_size());
+        write_binary(std::as_writable_bytes(std::span {bytes}));
+        return bytes;
+    }
+
+    header.isBinary = false;
+    header.isBigEndian = false;
+    std::ostringstream text;
+    header.write(text);
+    const auto head = text.str();
+
+    ChunkWriter out;
+    out.append(head.data(), head.size());
+    write_ascii_elements(out);
+    return out.release();
+}
+
+void FileOut::
+rewrite(const std::filesystem::path& from,
+        const std::filesystem::path& to)
+{
+    MappedFile source {from};
+    ByteReader in {source};
+
+    FileIn file;
+    if (!file.header.parse(in))
+        throw std::runtime_error("malformed header in " + from.string());
+    if (!file.header.isBinary)
+        throw std::invalid_argument(from.string() + " is not binary; "
+                                    "transcode it first");
+
+    const auto offsets = file.element_offsets(in);
+
+    // The copied elements stay valid in the byte order of the source.
+    const bool sourceBigEndian = file.header.isBigEndian;
+    header.isBinary = true;
+    header.isBigEndian = sourceBigEndian;
+    const auto layouts = make_element_layouts();
+
+    // Elements of the source, replaced by those added here,
+    // followed by those added here only.
+    Header out;
+    out.isBinary = true;
+    out.isBigEndian = sourceBigEndian;
+    out.comments = file.header.comments;
+    out.comments.insert(out.comments.end(),
+                        header.comments.begin(), header.comments.end());
+    out.objInfo = file.header.objInfo;
+    out.objInfo.insert(out.objInfo.end(),
+                       header.objInfo.begin(), header.objInfo.end());
+
+    std::vector<ElementLayout const*> replaced;
+    for (const auto& e: file.header.elements) {
+        const auto layout = std::find_if(
+            layouts.begin(), layouts.end(),
+            [&](const auto& l) { return l.element->name == e.name; }
+        );
+        out.elements.push_back(layout == layouts.end() ? e : *layout->element);
+        replaced.push_back(layout == layouts.end() ? nullptr : &*layout);
+    }
+    for (const auto& layout: layouts)
+        if (!file.header.find_element(layout.element->name)) {
+            out.elements.push_back(*layout.element);
+            replaced.push_back(&layout);
+        }
+
+    std::ostringstream text;
+    out.write(text);
+    const auto head = text.str();
+
+    // Written aside, so that `to` may be `from`.
+    const auto tmp = temporary_path_for(to);
+    try {
+        RewriteSink sink {from, source.bytes(), tmp};
+        sink.write(reinterpret_cast<const uint8_t*>(head.data()), head.size());
+
+        ChunkWriter block;
+        for (size_t i {}; i < out.elements.size(); ++i) {
+
+            const auto layout = replaced[i];
+            if (!layout) {
+                sink.copy(offsets[i], offsets[i + 1] - offsets[i]);
+                continue;
+            }
+
+            const size_t count = layout->element->size;
+            if (layout->contiguous && !layout->swap) {
+                sink.write(layout->fields.front().data, count * layout->recordBytes);
+                continue;
+            }
+            for (size_t b {}; b < count; b += recordsPerBlock) {
+                block.clear();
+                write_binary_records(block, *layout, b, std::min(b + recordsPerBlock, count));
+                sink.write(block.data(), block.size());
+            }
+        }
+    }
+    catch (...) {
+        std::error_code ec;
+        std::filesystem::remove(tmp, ec);
+        throw;
+    }
+    std::filesystem::rename(tmp, to);
+}
+
+bool FileOut::
+write_binary_mapped(const std::filesystem::path& p)
+{
+#if defined(__unix__)
+
+    const auto head = binary_header();
+
+    const auto layouts = make_element_layouts();
+    size_t total = head.size();
+    for (const auto& layout: layouts)
+        total += binary_size(layout);
+
+    // Filled aside and renamed over `p` once on disk, so that a failure
+    // leaves neither a partial file nor one of zeros at `p`.
+    const auto tmp = temporary_path_for(p);
+    const int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+        return false;
+
+    // The blocks are allocated here rather than on first touch of the map,
+    // where a full disk would raise SIGBUS; the stream is used if they can't.
+    void* map = MAP_FAILED;
+    if (::posix_fallocate(fd, 0, static_cast<off_t>(total)) == 0)
+        map = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);  // the mapping stays valid
+    if (map == MAP_FAILED) {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+
+    struct Unmap {
+        void* map;
+        size_t size;
+        ~Unmap() { ::munmap(map, size); }
+    };
+    try {
+        {
+            const Unmap unmap {map, total};
+
+            auto* dst = static_cast<uint8_t*>(map);
+            std::memcpy(dst, head.data(), head.size());
+            fill_binary(dst + head.size(), layouts);
+
+            // munmap does not report errors of the write-back.
+            if (::msync(map, total, MS_SYNC) != 0)
+                throw std::runtime_error("failed to write " + p.string());
+        }
+        std::filesystem::rename(tmp, p);
+    }
+    catch (...) {
+        std::error_code ec;
+        std::filesystem::remove(tmp, ec);
+        throw;
+    }
+
+    return true;
+
+#else
+    (void)p;
+    return false;
+#endif
+}
+
+void FileOut::
+set_output_type(const std::string& elementKey,
+                const std::vector<std::string>& propertyKeys,
+                const Type type,
+                const double scale)
+{
+    if (type == Type::INVALID)
+        throw std::invalid_argument("invalid output type");
+
+    const auto e = header.find_element(elementKey);
+    if (!e)
+        throw std::invalid_argument("no element '" + elementKey + "'");
+
+    for (const auto& key: propertyKeys) {
+
+        const auto helper = header.userData.find(elementKey, key);
+        Property* p {};
+        for (auto& q: e->properties)
+            if (q.name == key)
+                p = &q;
+        if (!helper || !p)
+            throw std::invalid_argument("no property '" + key +
+                                        "' in element '" + elementKey + "'");
+        p->scalarType = type;
+        helper->scale = scale;
+    }
+}
+
+void FileOut::
+add_list_property_to_element(const std::string& elementKey,
+                             const std::string& propertyKey,
+                             const Type type,
+                             const size_t count,
+                             uint8_t const* values,
+                             const Type listType,
+                             size_t const* offsets)
+{
+    if (listType == Type::INVALID)
+        throw std::invalid_argument("`listType` of '" + propertyKey +
+                                    "' must be a valid type");
+
+    ParsingHelper helper;
+    helper.data = std::make_shared<Data>(type, Buffer(values), count, true);
+    helper.cursor = std::make_shared<DataCursor>();
+    helper.listOffsets = offsets;
+    header.userData.insert(elementKey, propertyKey, std::move(helper));
+
+    auto e = header.find_element(elementKey);
+    if (!e)
+        e = &header.elements.emplace_back(elementKey, count);
+    e->create_properties({propertyKey}, type, listType, 0);
+}
+
+void FileOut::
+write_ascii_values(ChunkWriter& out,
+                   const FieldSource& f,
+                   uint8_t const* src,
+                   const size_t n)
+{
+    uint8_t converted[sizeof(double)];
+
+    for (size_t j {}; j < n; ++j, src += f.info->stride) {
+
+        const uint8_t* value = src;
+        if (f.convert) {
+            f.emit(converted, src, 1);
+            value = converted;
+        }
+
+        auto* const first = reinterpret_cast<char*>(out.reserve(maxAsciiChars));
+        auto* last = f.out->to_chars(first, first + maxAsciiChars, value);
+        *last++ = ' ';
+        out.commit(last - first);
+    }
+}
+
+void FileOut::
+write_ascii_records(ChunkWriter& out,
+                    const ElementLayout& layout,
+                    const size_t begin,
+                    const size_t end)
+{
+    for (size_t i = begin; i < end; ++i) {
+        for (const auto& f: layout.fields) {
+
+            const auto [src, n] = f.values(i);
+            if (f.listStride) {
+                auto* const first =
+                    reinterpret_cast<char*>(out.reserve(maxAsciiChars));
+                auto* last = std::to_chars(first,
+                                           first + maxAsciiChars,
+                                           n).ptr;
+                *last++ = ' ';
+                out.commit(last - first);
+            }
+            write_ascii_values(out, f, src, n);
+        }
+        *out.reserve(1) = '\n';
+        out.commit(1);
+    }
+}
+
+void FileOut::
+write_ascii(std::ostream& os)
 {
     header.write(os);
 
-    auto element_property_lookup = header.make_property_lookup_table();
+    ChunkWriter out {os, ChunkWriter::defaultChunkSize, queuedChunks};
+    write_ascii_elements(out);
+    out.flush();
+}
 
-    for (size_t element_idx = 0;
-         auto& e: header.elements) {
-        for (size_t i {}; i < e.size; ++i) {
-            for (size_t property_index = 0;
-                 auto& p: e.properties) {
+void FileOut::
+write_ascii_elements(ChunkWriter& out)
+{
+    const size_t n = numThreads ? numThreads
+                                : std::max(1u, std::thread::hardware_concurrency());
 
-                auto& f = element_property_lookup[element_idx][property_index];
-                auto* helper = f.helper;
+    // Text formatted by the other threads, emitted in the order of records.
+    std::vector<ChunkWriter> blocks(n - 1);
 
-                if (f.skip || helper == nullptr)
-                    continue;
+    for (const auto& layout: make_element_layouts()) {
 
-                if (p.is_list()) {
+        const size_t count = layout.element->size;
 
-                    os << p.listCount << " ";
-                    for (size_t j {}; j < p.listCount; ++j)
+        for (size_t begin {}; begin < count; ) {
 
-                        write_scalar_ascii(
-                            p.scalarType,
-                            os,
-                            helper->data->buffer.get() + helper->cursor->byteOffset,
-                            helper->cursor->byteOffset
-                        );
-                }
-                else
-                    write_scalar_ascii(
-                        p.scalarType,
-                        os,
-                        helper->data->buffer.get() + helper->cursor->byteOffset,
-                        helper->cursor->byteOffset
-                    );
-
-                property_index++;
+            // The calling thread formats the first block of a round straight
+            // into the output, while the other threads take the next ones.
+            const size_t end = std::min(begin + recordsPerBlock, count);
+            size_t next = end;
+
+            std::vector<std::future<void>> tasks;
+            while (next < count && tasks.size() < blocks.size()) {
+                const size_t e = std::min(next + recordsPerBlock, count);
+                auto& block = blocks[tasks.size()];
+                block.clear();
+                tasks.push_back(std::async(std::launch::async,
+                                           [&block, &layout, next, e] {
+                    write_ascii_records(block, layout, next, e);
+                }));
+                next = e;
+            }
+
+            write_ascii_records(out, layout, begin, end);
+
+            for (size_t k {}; k < tasks.size(); ++k) {
+                tasks[k].get();
+                out.append(blocks[k].data(), blocks[k].size());
             }
-            os << "\n";
+            begin = next;
         }
-        element_idx++;
     }
 }
 
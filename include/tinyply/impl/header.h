@@ -24,13 +24,16 @@
 #ifndef TINYPLY_IMPL_HEADER_H
 #define TINYPLY_IMPL_HEADER_H
 
+#include "byte_source.h"
 #include "element.h"
 #include "user_data.h"
 
+#include <algorithm>
+#include <charconv>  // from_chars
+#include <iomanip>  // setw, setfill
 #include <iostream>
 #include <istream>
 #include <ostream>
-#include <sstream>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -59,15 +62,33 @@ namespace tinyply::impl {
         std::vector<std::vector<PropertyLookup>> make_property_lookup_table();
         constexpr Element* find_element(std::string_view key) noexcept;
 
+        /**
+         * True if `other` declares the same elements and properties in the
+         * same order, irrespective of the element sizes and the format.
+         */
+        bool has_schema_of(const Header& other) const noexcept;
+
+        size_t headerBytes {};  ///< header length, i.e. offset of the payload
+
         bool parse(std::istream& is);
-        void read_format(std::istream& is);
-        void read_element(std::istream& is);
-        void read_property(std::istream& is);
-        void read_text(std::string line,
+        bool parse(ByteReader& in);
+        bool parse(std::string_view text);
+        bool parse_line(std::string_view line,
+                        bool& success);
+        void read_format(std::string_view fields);
+        void read_element(std::string_view fields);
+        void read_property(std::string_view fields);
+        void read_text(std::string_view line,
                        std::vector<std::string>& place,
-                       int erase = 0);
+                       size_t erase = 0);
 
-        void write(std::ostream& os) noexcept;
+        /**
+         * A nonzero `countWidth` pads the element counts with leading zeros
+         * to that many digits, so the header keeps its length when
+         * rewritten with other counts.
+         */
+        void write(std::ostream& os,
+                   size_t countWidth = 0) noexcept;
 
         void report() const noexcept;
     };
@@ -127,51 +148,119 @@ find_element(std::string_view key) noexcept
     return nullptr;
 }
 
+bool Header::
+has_schema_of(const Header& other) const noexcept
+{
+    if (elements.size() != other.elements.size())
+        return false;
+
+    for (size_t i {}; i < elements.size(); ++i) {
 
+        const auto& a = elements[i];
+        const auto& b = other.elements[i];
+        if (a.name != b.name || a.properties.size() != b.properties.size())
+            return false;
+
+        for (size_t j {}; j < a.properties.size(); ++j) {
+
+            const auto& p = a.properties[j];
+            const auto& q = b.properties[j];
+            if (p.name != q.name ||
+                p.scalarType != q.scalarType ||
+                p.listType != q.listType)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Header lines are tokenized in place as string views: no per-line streams
+// are created and names are copied once, into the Element and Property.
 bool Header::
 parse(std::istream& is)
 {
     std::string line;
     bool success = true;
+    headerBytes = 0;
     while (std::getline(is, line)) {
 
-        std::istringstream ls(line);
-        std::string token;
-        ls >> token;
-
-        if (token == "ply" ||
-            token == "PLY" ||
-            token == "") continue;
-
-        else if (token == "comment")    read_text(line, comments, 8);
-        else if (token == "format")     read_format(ls);
-        else if (token == "element")    read_element(ls);
-        else if (token == "property")   read_property(ls);
-        else if (token == "obj_info")   read_text(line, objInfo, 9);
-        else if (token == "end_header") break;
-        else { // unexpected header field
-            std::cerr << "Unexpected header field encountered: " << token
-                      << std::endl;
-            success = false;
-        }
+        headerBytes += line.size() + 1;
+        if (parse_line(line, success))
+            break;
+    }
+    return success;
+}
+
+bool Header::
+parse(ByteReader& in)
+{
+    std::string_view line;
+    bool success = true;
+    headerBytes = 0;
+    while (in.line(line)) {
+
+        headerBytes += line.size() + 1;
+        if (parse_line(line, success))
+            break;
+    }
+    return success;
+}
+
+bool Header::
+parse(std::string_view text)
+{
+    bool success = true;
+    headerBytes = 0;
+    while (headerBytes < text.size()) {
+
+        const auto eol = text.find('\n', headerBytes);
+        const auto line = text.substr(headerBytes, eol - headerBytes);
+        headerBytes = eol == std::string_view::npos ? text.size()
+                                                    : eol + 1;
+        if (parse_line(line, success))
+            break;
     }
     return success;
 }
 
+// Returns true once 'end_header' is reached.
+bool Header::
+parse_line(std::string_view line,
+           bool& success)
+{
+    auto fields = line;
+    const auto token = next_token(fields);
+
+    if (token == "ply" ||
+        token == "PLY" ||
+        token == "") return false;
+
+    else if (token == "comment")    read_text(line, comments, 8);
+    else if (token == "format")     read_format(fields);
+    else if (token == "element")    read_element(fields);
+    else if (token == "property")   read_property(fields);
+    else if (token == "obj_info")   read_text(line, objInfo, 9);
+    else if (token == "end_header") return true;
+    else { // unexpected header field
+        std::cerr << "Unexpected header field encountered: " << token
+                  << std::endl;
+        success = false;
+    }
+    return false;
+}
+
 void Header::
-read_text(std::string line,
+read_text(std::string_view line,
           std::vector<std::string>& place,
-          const int erase)
+          const size_t erase)
 {
-    place.push_back(erase > 0 ? line.erase(0, erase)
-                              : line);
+    place.emplace_back(line.substr(std::min(erase, line.size())));
 }
 
 void Header::
-read_format(std::istream& is)
+read_format(std::string_view fields)
 {
-    std::string s;
-    is >> s;
+    const auto s = next_token(fields);
 
     if (s == "binary_little_endian")
         isBinary = true;
@@ -180,22 +269,49 @@ read_format(std::istream& is)
 }
 
 void Header::
-read_element(std::istream& is)
+read_element(std::string_view fields)
 {
-    elements.emplace_back(is);
+    const auto name = next_token(fields);
+    const auto count = next_token(fields);
+
+    size_t size {};
+    const auto end = count.data() + count.size();
+    const auto [ptr, ec] = std::from_chars(count.data(), end, size);
+    if (ec != std::errc() || ptr != end)
+        throw std::runtime_error("invalid size of element '" + std::string(name) +
+                                 "': '" + std::string(count) + "'");
+
+    elements.emplace_back(std::string(name), size);
 }
 
 void Header::
-read_property(std::istream& is)
+read_property(std::string_view fields)
 {
     if (!elements.size())
         throw std::runtime_error("no elements defined; file is malformed");
 
-    elements.back().properties.emplace_back(is);
+    auto& properties = elements.back().properties;
+    const auto type = next_token(fields);
+
+    if (type == "list") {
+
+        const auto listType = Property::type_from_string(next_token(fields));
+        const auto scalarType = Property::type_from_string(next_token(fields));
+        properties.emplace_back(listType,
+                                scalarType,
+                                std::string(next_token(fields)),
+                                0);
+    }
+    else {
+        const auto scalarType = Property::type_from_string(type);
+        properties.emplace_back(scalarType,
+                                std::string(next_token(fields)));
+    }
 }
 
 void Header::
-write(std::ostream& os) noexcept
+write(std::ostream& os,
+      const size_t countWidth) noexcept
 {
     const std::locale& fixLoc = std::locale("C");
     os.imbue(fixLoc);
@@ -209,19 +325,25 @@ write(std::ostream& os) noexcept
 
     for (const auto& comment: comments)
         os << "comment " << comment << "\n";
+    for (const auto& info: objInfo)
+        os << "obj_info " << info << "\n";
 
+    // A header without requested properties, e.g. as parsed, is written whole.
+    const bool whole = userData.get().empty();
     auto property_lookup = make_property_lookup_table();
 
     size_t element_idx {};
     for (auto& e: elements) {
 
-        os << "element " << e.name << " " << e.size << "\n";
+        os << "element " << e.name << " "
+           << std::setfill('0') << std::setw(countWidth) << e.size
+           << std::setfill(' ') << "\n";
         size_t property_idx = 0;
         for (const auto& p: e.properties) {
 
             PropertyLookup& lookup = property_lookup[element_idx][property_idx];
 
-            if (!lookup.skip) {
+            if (whole || !lookup.skip) {
                 if (p.is_list()) {
 
                     os << "property list "
@@ -0,0 +1,229 @@
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TINYPLY_IMPL_INTERLEAVE_H
+#define TINYPLY_IMPL_INTERLEAVE_H
+
+#include "misc.h"
+#include "types.h"
+
+#include <array>
+#include <cmath>  // round
+#include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
+#include <cstring>  // memcpy
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>  // cmp_less, cmp_greater, index_sequence
+
+namespace tinyply::impl {
+
+    /**
+     * Copies `n` values of `Bytes` bytes between two strided arrays.
+     * The fixed size turns each copy into plain register moves.
+     */
+    template<size_t Bytes>
+    inline void copy_strided(uint8_t* dst,
+                             const size_t dstStride,
+                             uint8_t const* src,
+                             const size_t srcStride,
+                             const size_t n) noexcept
+    {
+        for (size_t i {}; i < n; ++i, dst += dstStride, src += srcStride)
+            std::memcpy(dst, src, Bytes);
+    }
+
+    /**
+     * Copies `n` values of `bytes` bytes between two strided arrays, e.g.
+     * one property of separate or padded source records into the records
+     * of the output. A zero `srcStride` repeats the same value.
+     */
+    inline void copy_strided(uint8_t* dst,
+                             const size_t dstStride,
+                             uint8_t const* src,
+                             const size_t srcStride,
+                             const size_t n,
+                             const size_t bytes) noexcept
+    {
+        switch (bytes) {
+            case 1:  return copy_strided<1>(dst, dstStride, src, srcStride, n);
+            case 2:  return copy_strided<2>(dst, dstStride, src, srcStride, n);
+            case 4:  return copy_strided<4>(dst, dstStride, src, srcStride, n);
+            case 8:  return copy_strided<8>(dst, dstStride, src, srcStride, n);
+            case 12: return copy_strided<12>(dst, dstStride, src, srcStride, n);
+            case 16: return copy_strided<16>(dst, dstStride, src, srcStride, n);
+            case 24: return copy_strided<24>(dst, dstStride, src, srcStride, n);
+            default:
+                for (size_t i {}; i < n; ++i, dst += dstStride, src += srcStride)
+                    std::memcpy(dst, src, bytes);
+        }
+    }
+
+    /**
+     * Reverses the byte order of `count` consecutive values of `Bytes`
+     * bytes in each of `n` records `stride` bytes apart.
+     */
+    template<size_t Bytes>
+    inline void swap_strided(uint8_t* p,
+                             const size_t stride,
+                             const size_t n,
+                             const size_t count) noexcept
+    {
+        using U = std::conditional_t<Bytes == 2, uint16_t,
+                  std::conditional_t<Bytes == 4, uint32_t, uint64_t>>;
+
+        for (size_t i {}; i < n; ++i, p += stride)
+            for (size_t j {}; j < count; ++j) {
+                U v;
+                std::memcpy(&v, p + j * Bytes, Bytes);
+                v = endian_swap<U, U>(v);
+                std::memcpy(p + j * Bytes, &v, Bytes);
+            }
+    }
+
+    inline void swap_strided(uint8_t* p,
+                             const size_t stride,
+                             const size_t n,
+                             const size_t count,
+                             const size_t bytes) noexcept
+    {
+        switch (bytes) {
+            case 2:  return swap_strided<2>(p, stride, n, count);
+            case 4:  return swap_strided<4>(p, stride, n, count);
+            case 8:  return swap_strided<8>(p, stride, n, count);
+            default: return;  // single bytes have no order
+        }
+    }
+
+    /**
+     * Converts a value to the type `To`, multiplied by `scale` if `Scaled`.
+     * Conversions to integers round to nearest and saturate at the limits
+     * of `To`, NaN becoming zero.
+     */
+    template<typename To, bool Scaled, typename From>
+    constexpr To convert_value(const From v,
+                               const double scale) noexcept
+    {
+        if constexpr (std::is_floating_point_v<To>) {
+            if constexpr (Scaled)
+                return static_cast<To>(v * scale);
+            else
+                return static_cast<To>(v);
+        }
+        else if constexpr (std::is_integral_v<From> && !Scaled) {
+            if (std::cmp_less(v, std::numeric_limits<To>::lowest()))
+                return std::numeric_limits<To>::lowest();
+            if (std::cmp_greater(v, std::numeric_limits<To>::max()))
+                return std::numeric_limits<To>::max();
+            return static_cast<To>(v);
+        }
+        else {
+            const double d = std::round(Scaled ? v * scale : double(v));
+            if (d != d)
+                return To {};
+            if (d <= double(std::numeric_limits<To>::lowest()))
+                return std::numeric_limits<To>::lowest();
+            if (d >= double(std::numeric_limits<To>::max()))
+                return std::numeric_limits<To>::max();
+            return static_cast<To>(d);
+        }
+    }
+
+    template<typename From, typename To, bool Scaled>
+    void convert_strided(uint8_t* dst,
+                         const size_t dstStride,
+                         uint8_t const* src,
+                         const size_t srcStride,
+                         const size_t n,
+                         const size_t count,
+                         const double scale) noexcept
+    {
+        for (size_t i {}; i < n; ++i, dst += dstStride, src += srcStride)
+            for (size_t j {}; j < count; ++j) {
+                From v;
+                std::memcpy(&v, src + j * sizeof(From), sizeof(From));
+                const To w = convert_value<To, Scaled>(v, scale);
+                std::memcpy(dst + j * sizeof(To), &w, sizeof(To));
+            }
+    }
+
+    /**
+     * Converts `n` strided records of `count` values each, see `convert_value`.
+     */
+    template<typename From, typename To>
+    void convert_strided(uint8_t* dst,
+                         const size_t dstStride,
+                         uint8_t const* src,
+                         const size_t srcStride,
+                         const size_t n,
+                         const size_t count,
+                         const double scale) noexcept
+    {
+        scale == 1
+            ? convert_strided<From, To, false>(dst, dstStride, src, srcStride,
+                                               n, count, scale)
+            : convert_strided<From, To, true>(dst, dstStride, src, srcStride,
+                                              n, count, scale);
+    }
+
+    using Converter = void (*)(uint8_t*, size_t, uint8_t const*, size_t,
+                               size_t, size_t, double) noexcept;
+
+    template<size_t From, size_t To>
+    constexpr Converter converter_at() noexcept
+    {
+        if constexpr (From == 0 || To == 0)  // Type::INVALID
+            return nullptr;
+        else
+            return &convert_strided<std::tuple_element_t<From, typetup>,
+                                    std::tuple_element_t<To, typetup>>;
+    }
+
+    template<size_t From, size_t... To>
+    constexpr auto converter_row(std::index_sequence<To...>) noexcept
+    {
+        return std::array<Converter, sizeof...(To)> {converter_at<From, To>()...};
+    }
+
+    template<size_t... From>
+    constexpr auto converter_table(std::index_sequence<From...> all) noexcept
+    {
+        return std::array {converter_row<From>(all)...};
+    }
+
+    /**
+     * The kernel converting values of type `from` to type `to`,
+     * nullptr if either is invalid.
+     */
+    inline Converter converter(const Type from,
+                               const Type to) noexcept
+    {
+        static constexpr auto table = converter_table(
+            std::make_index_sequence<std::tuple_size_v<typetup>>()
+        );
+        return table[static_cast<size_t>(from)][static_cast<size_t>(to)];
+    }
+
+}  // namespace tinyply::impl
+
+#endif  // TINYPLY_IMPL_INTERLEAVE_H
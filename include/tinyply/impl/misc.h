@@ -24,9 +24,12 @@
 #ifndef TINYPLY_IMPL_MISC_H
 #define TINYPLY_IMPL_MISC_H
 
+#include <atomic>
 #include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
-#include <istream>
+#include <filesystem>
+#include <random>  // random_device
 #include <string>
+#include <string_view>
 
 namespace tinyply::impl {
 
@@ -140,21 +143,45 @@ uint32_t hash_fnv1a(const std::string& str) noexcept
     return result;
 }
 
-// ascii =======================================================================
+// Tokens ======================================================================
 
-template<typename T>
-T read_ascii(std::istream& is)
+/**
+ * Splits off the next whitespace-delimited token of `s`, advancing `s` past it.
+ * Returns an empty view if no token is left.
+ */
+constexpr
+std::string_view next_token(std::string_view& s) noexcept
 {
-    T data;
-    is >> data;
-    return data;
+    constexpr std::string_view whitespace {" \t\r"};
+
+    const auto begin = s.find_first_not_of(whitespace);
+    if (begin == std::string_view::npos) {
+        s = {};
+        return {};
+    }
+    s.remove_prefix(begin);
+
+    const auto end = s.find_first_of(whitespace);
+    const auto token = s.substr(0, end);
+    s.remove_prefix(token.size());
+
+    return token;
 }
 
-template<typename T>
-void cast_ascii(void* dest,
-                std::istream& is)
+// Files =======================================================================
+
+/**
+ * A new path next to `p`, for a replacement of `p` written in full before
+ * it is renamed over `p`, so that `p` can be read while it is written.
+ */
+inline std::filesystem::path temporary_path_for(const std::filesystem::path& p)
 {
-    *(static_cast<T*>(dest)) = read_ascii<T>(is);
+    static std::atomic<uint32_t> counter {};
+
+    auto tmp = p;
+    tmp += ".tmp-" + std::to_string(std::random_device {}()) +
+           "-" + std::to_string(counter++);
+    return tmp;
 }
 
 
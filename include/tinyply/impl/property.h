@@ -27,10 +27,12 @@
 #include "types.h"
 
 #include <cassert>
+#include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
 #include <iostream>
 #include <map>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace tinyply::impl {
 
@@ -43,8 +45,6 @@ namespace tinyply::impl {
         Type listType {Type::INVALID};
         size_t listCount {};
 
-        explicit Property(std::istream& is);
-
         explicit constexpr Property(
             const Type type,
             const std::string& name
@@ -65,9 +65,9 @@ namespace tinyply::impl {
             , listCount {listCount}
         {}
 
-        constexpr Type type_from_string(
+        static constexpr Type type_from_string(
             const std::string_view t
-        ) const noexcept;
+        ) noexcept;
 
         constexpr bool is_list() const noexcept
         {
@@ -77,32 +77,59 @@ namespace tinyply::impl {
         void report(std::string_view pref) const noexcept;
     };
 
+    /**
+     * A property as laid out in a user record: the values of the property
+     * start `offset` bytes into the record. Lists have a fixed length.
+     */
+    struct Field {
+
+        std::string name;
+        Type type {Type::INVALID};
+        size_t offset {};
+        Type listType {Type::INVALID};
+        size_t listCount {};
+
+        size_t bytes() const
+        {
+            return types.at(type).stride *
+                   (listType == Type::INVALID ? 1 : listCount);
+        }
+    };
+
+    /**
+     * Where the fields of user records sit in the records of a binary file,
+     * those being of fixed size.
+     */
+    struct RecordLayout {
+
+        std::vector<size_t> at;          ///< of the values of each field
+        std::vector<size_t> countBytes;  ///< of the list count before them, 0 if not a list
+        size_t recordBytes {};
+        bool bigEndian {};
+    };
+
+    /**
+     * Decodes `n` records of a binary file at `src` into user records at `dst`.
+     */
+    using RecordDecoder = void (*)(uint8_t const* src,
+                                   size_t n,
+                                   uint8_t* dst,
+                                   const RecordLayout& layout);
+
 }  // namespace tinyply::impl
 
+namespace tinyply {
+    using Field = impl::Field;
+}  // namespace tinyply
+
 
 // IMPLEMENTATION ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 #ifdef TINYPLY_AS_LIBRARY
 
 namespace tinyply::impl {
 
-Property::
-Property(std::istream& is)
-{
-    std::string type;
-    is >> type;
-    if (type == "list") {
-
-        std::string countType;
-        is >> countType >> type;
-        listType = type_from_string(countType);
-        assert(is_list());
-    }
-    scalarType = type_from_string(type);
-    is >> name;
-}
-
 constexpr Type Property::
-type_from_string(const std::string_view t) const noexcept
+type_from_string(const std::string_view t) noexcept
 {
     if      (t == "int8" || t == "char")      return Type::INT8;
     else if (t == "uint8" || t == "uchar")    return Type::UINT8;
@@ -26,12 +26,18 @@
 
 #include "misc.h"
 
+#include <charconv>  // to_chars
 #include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
-#include <istream>
+#include <cstring>  // memcpy
 #include <map>
 #include <ostream>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <system_error>  // errc
 #include <tuple>
+#include <type_traits>
+#include <utility>  // in_range
 
 
 namespace tinyply {
@@ -77,11 +83,63 @@ namespace impl {
     template<Type T>
     using type = std::tuple_element_t<static_cast<size_t>(T), typetup>;
 
+    /// Buffer size sufficient for the shortest round-trip representation of
+    /// a value of any type, e.g. "-2.2250738585072014e-308", and a separator.
+    inline constexpr size_t maxAsciiChars {32};
+
+    /**
+     * Formats the value at `src` into [first, last), locale-independently
+     * and, for floating point, as the shortest string reading back exactly.
+     * \returns the end of the characters written.
+     */
+    template<typename T>
+    char* to_chars(char* first,
+                   char* last,
+                   const uint8_t* src) noexcept
+    {
+        T v;
+        std::memcpy(&v, src, sizeof(T));
+
+        if constexpr (sizeof(T) == 1)  // as numbers, not characters
+            return std::to_chars(first, last, static_cast<int32_t>(v)).ptr;
+        else
+            return std::to_chars(first, last, v).ptr;
+    }
+
+    /**
+     * Reads the value of `token` into `dst`, locale-independently.
+     * A malformed token, or one out of the range of `T`, reads as zero.
+     * \returns false if the token is malformed.
+     */
+    template<typename T>
+    bool from_chars(std::string_view token,
+                    void* dst) noexcept
+    {
+        if (token.starts_with('+'))
+            token.remove_prefix(1);
+
+        // As numbers, not characters.
+        using Read = std::conditional_t<sizeof(T) == 1, int32_t, T>;
+        Read v {};
+        const auto end = token.data() + token.size();
+        const auto [ptr, ec] = std::from_chars(token.data(), end, v);
+        bool valid = ec == std::errc {} && ptr == end;
+        if constexpr (sizeof(T) == 1)
+            valid = valid && std::in_range<T>(v);
+
+        const auto value = valid ? static_cast<T>(v) : T {};
+        std::memcpy(dst, &value, sizeof(T));
+
+        return valid;
+    }
+
     struct Info {
 
         const Type t;
         const int stride;
         const std::string_view str;
+        char* (* const to_chars)(char*, char*, const uint8_t*) noexcept;
+        bool (* const from_chars)(std::string_view, void*) noexcept;
 
         int write_ascii(std::ostream& os,
                         const uint8_t* src) const
@@ -101,21 +159,20 @@ namespace impl {
             return stride;
         }
 
-        int read_ascii(std::istream& is,
+        /**
+         * Throws std::runtime_error if `token` is not a value of the type,
+         * or out of its range. An empty token, at the end of the input,
+         * reads as zero.
+         */
+        int read_ascii(std::string_view token,
                        void* dest) const
         {
-            switch (t) {
+            if (t == Type::INVALID)
+                throw std::invalid_argument("invalid ply type");
 
-                case Type::INT8:    *((int8_t*)dest)  = static_cast<int8_t>(impl::read_ascii<int32_t>(is));   break;
-                case Type::UINT8:   *((uint8_t*)dest) = static_cast<uint8_t>(impl::read_ascii<uint32_t>(is)); break;
-                case Type::INT16:   cast_ascii<int16_t>(dest, is);   break;
-                case Type::UINT16:  cast_ascii<uint16_t>(dest, is);  break;
-                case Type::INT32:   cast_ascii<int32_t>(dest, is);   break;
-                case Type::UINT32:  cast_ascii<uint32_t>(dest, is);  break;
-                case Type::FLOAT32: cast_ascii<float>(dest, is);     break;
-                case Type::FLOAT64: cast_ascii<double>(dest, is);    break;
-                case Type::INVALID: throw std::invalid_argument("invalid ply type");
-            }
+            if (!from_chars(token, dest) && !token.empty())
+                throw std::runtime_error("malformed " + std::string(str) +
+                                         " value: " + std::string(token));
 
             return stride;
         }
@@ -123,15 +180,15 @@ namespace impl {
 
     static inline const std::map<const Type, const Info> types
     {
-        { Type::INT8,    Info(Type::INT8, 1, "char") },
-        { Type::UINT8,   Info(Type::UINT8, 1, "uchar") },
-        { Type::INT16,   Info(Type::INT16, 2, "short") },
-        { Type::UINT16,  Info(Type::UINT16, 2, "ushort") },
-        { Type::INT32,   Info(Type::INT32, 4, "int") },
-        { Type::UINT32,  Info(Type::UINT32, 4, "uint") },
-        { Type::FLOAT32, Info(Type::FLOAT32, 4, "float") },
-        { Type::FLOAT64, Info(Type::FLOAT64, 8, "double") },
-        { Type::INVALID, Info(Type::INVALID, 0, "INVALID") }
+        { Type::INT8,    Info(Type::INT8, 1, "char", to_chars<int8_t>, from_chars<int8_t>) },
+        { Type::UINT8,   Info(Type::UINT8, 1, "uchar", to_chars<uint8_t>, from_chars<uint8_t>) },
+        { Type::INT16,   Info(Type::INT16, 2, "short", to_chars<int16_t>, from_chars<int16_t>) },
+        { Type::UINT16,  Info(Type::UINT16, 2, "ushort", to_chars<uint16_t>, from_chars<uint16_t>) },
+        { Type::INT32,   Info(Type::INT32, 4, "int", to_chars<int32_t>, from_chars<int32_t>) },
+        { Type::UINT32,  Info(Type::UINT32, 4, "uint", to_chars<uint32_t>, from_chars<uint32_t>) },
+        { Type::FLOAT32, Info(Type::FLOAT32, 4, "float", to_chars<float>, from_chars<float>) },
+        { Type::FLOAT64, Info(Type::FLOAT64, 8, "double", to_chars<double>, from_chars<double>) },
+        { Type::INVALID, Info(Type::INVALID, 0, "INVALID", nullptr, nullptr) }
     };
 
     void endian_reverse(Type t, void* dst)
@@ -147,11 +204,50 @@ namespace impl {
 
     }
 
+    /**
+     * The list count of type `t` at `src`, in the native byte order.
+     */
+    inline uint32_t load_list_count(const Type t,
+                                    const void* src) noexcept
+    {
+        switch (t) {
+
+            case Type::INT8:
+            case Type::UINT8:  { uint8_t n;  std::memcpy(&n, src, sizeof(n)); return n; }
+            case Type::INT16:
+            case Type::UINT16: { uint16_t n; std::memcpy(&n, src, sizeof(n)); return n; }
+            default:           { uint32_t n; std::memcpy(&n, src, sizeof(n)); return n; }
+        }
+    }
+
+    /**
+     * Stores the list count `n` at `dst` as a value of type `t`,
+     * in the native byte order.
+     */
+    inline void store_list_count(const Type t,
+                                 const uint32_t n,
+                                 void* dst) noexcept
+    {
+        switch (t) {
+
+            case Type::INT8:
+            case Type::UINT8:  { const auto v = static_cast<uint8_t>(n);  std::memcpy(dst, &v, sizeof(v)); break; }
+            case Type::INT16:
+            case Type::UINT16: { const auto v = static_cast<uint16_t>(n); std::memcpy(dst, &v, sizeof(v)); break; }
+            default:           std::memcpy(dst, &n, sizeof(n));
+        }
+    }
+
 }  // namespace impl
 
 using Type = impl::Type;
 template<Type T> using type = impl::type<T>;
 
+/// The ply type of values of the C++ type `T`.
+template<typename T>
+inline constexpr Type type_of =
+    static_cast<Type>(impl::Index<T, impl::typetup>::value);
+
 }  // namespace tinyply
 
 #ifdef TINYPLY_AS_LIBRARY
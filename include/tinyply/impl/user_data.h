@@ -24,6 +24,7 @@
 #ifndef TINYPLY_IMPL_USER_DATA_H
 #define TINYPLY_IMPL_USER_DATA_H
 
+#include "impl/data_buffer.h"
 #include "impl/element.h"
 #include "impl/misc.h"
 #include "impl/property.h"
@@ -41,12 +42,18 @@ namespace tinyply::impl {
         std::shared_ptr<Data> data;
         std::shared_ptr<DataCursor> cursor;
         uint32_t list_size_hint;
+
+        // Layout of the property in the user memory, when writing:
+        size_t offset {};  ///< of the property value within a record
+        size_t stride {};  ///< distance between consecutive records
+        size_t const* listOffsets {};  ///< of variable-length lists, count + 1
+        double scale {1};  ///< applied when converting to another output type
     };
 
 
     struct UserData {
 
-        using Map = std::unordered_map<uint32_t, const ParsingHelper>;
+        using Map = std::unordered_map<uint32_t, ParsingHelper>;
 
         Map dataMap;
 
@@ -80,6 +87,14 @@ namespace tinyply::impl {
                                        : &(it->second);
         }
 
+        ParsingHelper* find(const std::string& elementName,
+                            const std::string& propertyName) noexcept
+        {
+            const auto it = dataMap.find(hash_fnv1a(elementName + propertyName));
+            return it == dataMap.end() ? nullptr
+                                       : &(it->second);
+        }
+
         Map& get() noexcept
         {
             return dataMap;
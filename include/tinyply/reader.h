@@ -24,10 +24,12 @@
 #ifndef TINYPLY_READER_H
 #define TINYPLY_READER_H
 
+#include "impl/byte_source.h"
 #include "impl/data_buffer.h"
 #include "impl/element.h"
 #include "impl/file_in.h"
 #include "impl/types.h"
+#include "schema.h"
 
 #include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
 #include <istream>
@@ -58,12 +60,40 @@ namespace tinyply {
          */
         bool parse_header(std::istream& is);
 
+        /**
+         * Same as above, pulling the file from a byte source, e.g. a
+         * MemorySource, a MappedFile or a decompressor. The payload is then
+         * read by `read(...)` from the same source, without copying the
+         * spans of memory sources; the source must live until then.
+         */
+        bool parse_header(ByteSource& source);
+
+        /**
+         * Same as above, for a header already held in memory, e.g. a small
+         * file loaded in one go. `text` may extend past 'end_header';
+         * the payload then starts at `header_size()` bytes into it.
+         */
+        bool parse_header(std::string_view text);
+        size_t header_size() const noexcept;
+
         /**
          * Execute a read operation.
          * Data must be requested via `request_properties_from_element(...)`
-         * prior to calling this function.
+         * prior to calling this function. Reading stops after the last
+         * element holding requested properties, so the stream is not
+         * necessarily consumed to its end. Unless the header was parsed
+         * from `source`, its data start at the current position of `source`.
          */
         void read(std::istream& is);
+        void read(ByteSource& source);
+
+        /**
+         * Reports the memory `read(...)` is going to allocate for the data
+         * requested so far: bytes per requested property group, their total,
+         * and whether a counting pass over the file is required.
+         * Sizes are exact unless a list is requested without a size hint.
+         */
+        impl::ReadPlan plan() const;
 
         /*
          * These functions are valid after a call to `parse_header(...)`.
@@ -89,6 +119,38 @@ namespace tinyply {
             uint32_t list_size_hint = 0
         );
 
+        /**
+         * Requests properties of different types, read into one array of
+         * records of `stride` bytes: each field names a property and the
+         * byte offset of its value in the record, e.g.
+         * `{{"x", Type::FLOAT32, offsetof(Point, x)}, ...}`. A field type
+         * left invalid takes the type of the file, otherwise it must match.
+         * Lists must be of the fixed length `listCount`.
+         */
+        std::shared_ptr<impl::Data> request_record_from_element(
+            const std::string& elementKey,
+            const std::vector<Field>& fields,
+            size_t stride
+        );
+
+        /**
+         * Same as above for a struct bound with TINYPLY_BIND, the buffer
+         * then holding records of type `T`. Binary files whose records
+         * have the layout of `T` are read without decoding the properties;
+         * other binary files of fixed-size records, by a decode loop
+         * compiled for `T`.
+         */
+        template<Bound T>
+        std::shared_ptr<impl::Data> request_record_from_element(
+            const std::string& elementKey
+        )
+        {
+            return file->request_record_from_element(elementKey,
+                                                     impl::fields_of<T>(),
+                                                     sizeof(T),
+                                                     &impl::decode_records<T>);
+        }
+
         void report_structure() const noexcept;
     };
 
@@ -110,15 +172,48 @@ Reader()
 bool Reader::
 parse_header(std::istream& is)
 {
+    file->input = {};
     return file->header.parse(is);
 }
 
+bool Reader::
+parse_header(ByteSource& source)
+{
+    file->input = impl::ByteReader {source};
+    return file->header.parse(file->input);
+}
+
+bool Reader::
+parse_header(std::string_view text)
+{
+    file->input = {};
+    return file->header.parse(text);
+}
+
+size_t Reader::
+header_size() const noexcept
+{
+    return file->header.headerBytes;
+}
+
 void Reader::
 read(std::istream& is)
 {
     return file->read(is);
 }
 
+void Reader::
+read(ByteSource& source)
+{
+    return file->read(source);
+}
+
+impl::ReadPlan Reader::
+plan() const
+{
+    return file->plan();
+}
+
 std::vector<impl::Element> Reader::
 get_elements() const
 {
@@ -153,6 +248,14 @@ request_properties_from_element(const std::string& elementKey,
                                                  list_size_hint);
 }
 
+std::shared_ptr<impl::Data> Reader::
+request_record_from_element(const std::string& elementKey,
+                            const std::vector<Field>& fields,
+                            const size_t stride)
+{
+    return file->request_record_from_element(elementKey, fields, stride);
+}
+
 void Reader::
 report_structure() const noexcept
 {
@@ -0,0 +1,184 @@
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TINYPLY_SCHEMA_H
+#define TINYPLY_SCHEMA_H
+
+#include "impl/property.h"
+#include "impl/types.h"
+
+#include <array>
+#include <cstddef>  // offsetof
+#include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
+#include <cstring>  // memcpy
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>  // declval, index_sequence
+#include <vector>
+
+namespace tinyply {
+
+    /// Structs with members bound to properties by TINYPLY_BIND.
+    template<typename T>
+    concept Bound = requires (T const* p) { tinyply_bindings(p); };
+
+    /**
+     * The bindings of the members of `T`, found by argument-dependent
+     * lookup of the function TINYPLY_BIND defines.
+     */
+    template<Bound T>
+    struct Schema {
+        static constexpr auto fields = tinyply_bindings(static_cast<T const*>(nullptr));
+    };
+
+}  // namespace tinyply
+
+namespace tinyply::impl {
+
+    /**
+     * A struct member bound to a property. Arrays are fixed-length lists.
+     */
+    struct Binding {
+
+        std::string_view name;
+        Type type {Type::INVALID};
+        size_t offset {};
+        size_t listCount {};  ///< zero if not a list
+    };
+
+    template<typename M>
+    constexpr Binding bind(const std::string_view name,
+                           const size_t offset) noexcept
+    {
+        if constexpr (std::is_array_v<M>)
+            return {name, type_of<std::remove_extent_t<M>>, offset, std::extent_v<M>};
+        else
+            return {name, type_of<M>, offset};
+    }
+
+    /**
+     * Fields describing the records of a bound struct; list counts
+     * are written as uchar.
+     */
+    template<Bound T>
+    std::vector<Field> fields_of()
+    {
+        std::vector<Field> fields;
+        for (const auto& b: Schema<T>::fields)
+            fields.push_back({std::string(b.name),
+                              b.type,
+                              b.offset,
+                              b.listCount ? Type::UINT8 : Type::INVALID,
+                              b.listCount});
+        return fields;
+    }
+
+    inline uint32_t list_count(uint8_t const* p,
+                               const size_t bytes,
+                               const bool bigEndian) noexcept
+    {
+        uint32_t n {};
+        for (size_t i {}; i < bytes; ++i)
+            n = n << 8 | p[bigEndian ? i : bytes - 1 - i];
+        return n;
+    }
+
+    /**
+     * Copies the `K`-th bound member of `T` out of a file record; the size
+     * of the copy is known at compile time.
+     */
+    template<Bound T, size_t K>
+    inline void decode_field(uint8_t const* src,
+                             uint8_t* dst,
+                             const size_t at,
+                             const size_t countBytes,
+                             const bool bigEndian)
+    {
+        constexpr Binding b = Schema<T>::fields[K];
+        using V = std::tuple_element_t<static_cast<size_t>(b.type), typetup>;
+
+        if constexpr (b.listCount > 0)
+            if (list_count(src + at - countBytes, countBytes, bigEndian) != b.listCount)
+                throw std::runtime_error(
+                    "list '" + std::string(b.name) + "' is not of the requested length"
+                );
+
+        std::memcpy(dst + b.offset, src + at, sizeof(V) * (b.listCount ? b.listCount : 1));
+    }
+
+    /**
+     * The decode loop of a bound struct: one fixed-size copy per member and
+     * record, without looking up the property types. Byte order is left
+     * to the reader.
+     */
+    template<Bound T>
+    void decode_records(uint8_t const* src,
+                        const size_t n,
+                        uint8_t* dst,
+                        const RecordLayout& layout)
+    {
+        constexpr size_t N = Schema<T>::fields.size();
+        std::array<size_t, N> at;
+        std::array<size_t, N> countBytes;
+        for (size_t k {}; k < N; ++k) {
+            at[k] = layout.at[k];
+            countBytes[k] = layout.countBytes[k];
+        }
+
+        [&]<size_t... K>(std::index_sequence<K...>) {
+            for (size_t i {}; i < n; ++i, src += layout.recordBytes, dst += sizeof(T))
+                (decode_field<T, K>(src, dst, at[K], countBytes[K], layout.bigEndian), ...);
+        }(std::make_index_sequence<N>());
+    }
+
+}  // namespace tinyply::impl
+
+/**
+ * A member of the struct bound by TINYPLY_BIND, possibly nested, e.g.
+ * `TINYPLY_FIELD(position.x, "x")`, and the name of its property.
+ */
+#define TINYPLY_FIELD(member, name)                                           \
+    ::tinyply::impl::bind<                                                    \
+        std::remove_cvref_t<decltype(std::declval<Record&>().member)>         \
+    >(name, offsetof(Record, member))
+
+/**
+ * Binds the members of the struct `T` to ply properties, in the order of
+ * the properties in the file. To be used in the namespace of `T`:
+ *
+ *     TINYPLY_BIND(Vertex,
+ *                  TINYPLY_FIELD(x, "x"),
+ *                  TINYPLY_FIELD(y, "y"),
+ *                  TINYPLY_FIELD(rgb, "color"));  // uint8_t rgb[3]: a list
+ */
+#define TINYPLY_BIND(T, ...)                                                  \
+    [[maybe_unused]] constexpr auto tinyply_bindings(T const*) noexcept      \
+    {                                                                         \
+        using Record = T;                                                     \
+        return std::array {__VA_ARGS__};                                      \
+    }
+
+#endif  // TINYPLY_SCHEMA_H
@@ -0,0 +1,195 @@
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TINYPLY_SEQUENCE_READER_H
+#define TINYPLY_SEQUENCE_READER_H
+
+#include "impl/byte_source.h"
+#include "impl/data_buffer.h"
+#include "impl/file_in.h"
+#include "impl/file_loader.h"
+#include "impl/header.h"
+
+#include <array>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace tinyply {
+
+    using Request = impl::Request;
+
+    /**
+     * Reads a sequence of files sharing one header schema, e.g. the frames
+     * of a capture, with only the element sizes varying from file to file.
+     * The requests are compiled once and the buffers are kept from frame to
+     * frame, growing only if a frame needs more memory. While the caller
+     * consumes a frame, the following one is decoded in the background.
+     */
+    class SequenceReader {
+
+        struct Slot {
+
+            impl::FileLoader loader;  // holds the file contents and the reader
+            std::vector<std::shared_ptr<impl::Data>> data;
+            bool ready {};  // the requests are set up
+        };
+
+        std::vector<std::filesystem::path> paths;
+        std::vector<Request> requests;
+        impl::Header schema;  // of the first frame
+        std::array<Slot, 2> slots;  // frames alternate between the two
+
+    public:
+
+        using Data = impl::Data;
+
+        struct Frame {
+
+            std::filesystem::path path;
+            size_t index {};  ///< position in the sequence
+
+            /// One per request, in the order of the requests;
+            /// empty if the file does not contain the requested properties.
+            std::vector<std::shared_ptr<Data>> data;
+        };
+
+    private:
+
+        std::future<Frame> pending;  // declared last: joined first
+
+        Frame decode(size_t index);
+
+    public:
+
+        SequenceReader(std::vector<std::filesystem::path> paths,
+                       std::vector<Request> requests);
+
+        /**
+         * Returns the next frame, or nothing past the end of the sequence.
+         * The frame data remain valid until the following call, after which
+         * their memory is reused. Throws if the frame file cannot be read or
+         * its schema differs from that of the first frame.
+         */
+        std::optional<Frame> next();
+    };
+
+}  // namespace tinyply
+
+
+// IMPLEMENTATION ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+#ifdef TINYPLY_AS_LIBRARY
+
+namespace tinyply {
+
+SequenceReader::
+SequenceReader(std::vector<std::filesystem::path> paths,
+               std::vector<Request> requests)
+    : paths {std::move(paths)}
+    , requests {std::move(requests)}
+{
+    if (!this->paths.empty())
+        pending = std::async(std::launch::async, [this] { return decode(0); });
+}
+
+std::optional<SequenceReader::Frame> SequenceReader::
+next()
+{
+    if (!pending.valid())
+        return {};
+
+    Frame frame = pending.get();
+
+    // The caller is done with the previous frame: its slot is free.
+    if (const auto i = frame.index + 1; i < paths.size())
+        pending = std::async(std::launch::async, [this, i] { return decode(i); });
+
+    return frame;
+}
+
+SequenceReader::Frame SequenceReader::
+decode(const size_t index)
+{
+    const auto& path = paths[index];
+    auto& [loader, data, ready] = slots[index % slots.size()];
+    auto& file = loader.file;
+
+    loader.read_file(path);
+    impl::MemorySource source {loader.bytes};
+    impl::ByteReader in {source};
+
+    impl::Header header;
+    if (!header.parse(in))
+        throw std::runtime_error("malformed header in " + path.string());
+
+    // Frames are decoded one after another, the first one before any other.
+    if (index == 0)
+        schema = header;
+    else if (!schema.has_schema_of(header))
+        throw std::runtime_error(
+            path.string() + " does not match the schema of the sequence"
+        );
+
+    if (!ready) {  // first frame of the slot: set up the requests
+
+        file.header = std::move(header);
+        data.resize(requests.size());
+        for (size_t i {}; i < requests.size(); ++i) {
+
+            const auto element = file.header.find_element(requests[i].element);
+            if (!element)
+                continue;
+            try {
+                data[i] = file.request_properties_from_element(
+                    *element,
+                    requests[i].properties,
+                    requests[i].listSizeHint
+                );
+            }
+            catch (const std::invalid_argument&) {}
+        }
+        ready = true;
+    }
+    else {
+        for (size_t i {}; i < header.elements.size(); ++i) {
+            file.header.elements[i].size = header.elements[i].size;
+            for (auto& p: file.header.elements[i].properties)
+                p.listCount = 0;  // as found by the counting pass, if any
+        }
+        file.header.isBinary = header.isBinary;
+        file.header.isBigEndian = header.isBigEndian;
+        file.header.headerBytes = header.headerBytes;
+    }
+
+    file.read(in);
+
+    return {path, index, data};
+}
+
+}  // namespace tinyply
+
+#endif  // TINYPLY_AS_LIBRARY
+#endif  // TINYPLY_SEQUENCE_READER_H
@@ -0,0 +1,305 @@
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TINYPLY_STREAM_WRITER_H
+#define TINYPLY_STREAM_WRITER_H
+
+#include "impl/chunk_writer.h"
+#include "impl/file_out.h"
+#include "impl/header.h"
+#include "impl/types.h"
+
+#include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace tinyply {
+
+    /**
+     * Writes a ply file incrementally: the schema is declared up front and
+     * the records are appended in batches as they are produced, so that
+     * they never have to be held in memory all at once. The header is
+     * written with zero-padded element counts, which are patched in place
+     * by `close()`; the output stream must therefore be seekable.
+     */
+    class StreamWriter {
+
+        /// Digits of the element counts in the header, enough for any size_t.
+        static constexpr size_t countWidth {20};
+
+        std::unique_ptr<std::ofstream> file;  ///< if opened from a path
+        std::ostream* os {};
+        std::streampos start {};  ///< of the header in the stream
+
+        impl::Header header;
+        std::vector<impl::ElementLayout> layouts;  ///< one per element
+        std::optional<impl::ChunkWriter> out;
+        size_t current {};  ///< element receiving the records
+        size_t queuedChunks {};  ///< for a background writer thread
+        bool closed {};
+
+        void write_header();
+
+    public:
+
+        StreamWriter(const std::filesystem::path& p,
+                     bool asBinary);
+        StreamWriter(std::ostream& os,
+                     bool asBinary);
+
+        StreamWriter(const StreamWriter&) = delete;
+        StreamWriter& operator=(const StreamWriter&) = delete;
+
+        /**
+         * Closes the writer, ignoring errors; call `close()` to see them.
+         */
+        ~StreamWriter();
+
+        void add_comment(const std::string& str);
+
+        /**
+         * Writes full chunks of output on a background thread, with up to
+         * `queuedChunks` waiting, so that producing records overlaps with
+         * the disk writes. Takes effect if set before the first records.
+         */
+        void set_write_behind(size_t queuedChunks) noexcept;
+
+        /**
+         * Declares properties of an element, creating the element if needed.
+         * Lists must have a fixed length `listCount`. The schema is frozen
+         * once the first records are appended.
+         */
+        void add_properties_to_element(
+            const std::string& elementKey,
+            const std::vector<std::string>& propertyKeys,
+            impl::Type type,
+            impl::Type listType = impl::Type::INVALID,
+            size_t listCount = 0
+        );
+
+        /**
+         * Appends `count` records of an element. The records are packed
+         * back to back in `records`, with the values of each record in the
+         * order the properties were declared, lists without their counts.
+         * Elements are appended in the order they were declared, each in
+         * as many batches as needed.
+         */
+        void append(const std::string& elementKey,
+                    size_t count,
+                    uint8_t const* records);
+
+        /**
+         * Writes the remaining output and the final element counts.
+         */
+        void close();
+    };
+
+}  // namespace tinyply
+
+
+// IMPLEMENTATION ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+#ifdef TINYPLY_AS_LIBRARY
+
+namespace tinyply {
+
+StreamWriter::
+StreamWriter(const std::filesystem::path& p,
+             const bool asBinary)
+    : file {std::make_unique<std::ofstream>(p, std::ios::out | std::ios::binary)}
+    , os {file.get()}
+{
+    if (file->fail())
+        throw std::runtime_error("failed to open " + p.string());
+
+    header.isBinary = asBinary;
+}
+
+StreamWriter::
+StreamWriter(std::ostream& os,
+             const bool asBinary)
+    : os {&os}
+    , start {os.tellp()}
+{
+    if (start == std::streampos(-1))
+        throw std::invalid_argument("the output stream must be seekable");
+
+    header.isBinary = asBinary;
+}
+
+StreamWriter::
+~StreamWriter()
+{
+    try {
+        close();
+    }
+    catch (...) {}
+}
+
+void StreamWriter::
+add_comment(const std::string& str)
+{
+    if (out)
+        throw std::logic_error("comments must precede the records");
+
+    header.comments.push_back(str);
+}
+
+void StreamWriter::
+set_write_behind(const size_t queuedChunks) noexcept
+{
+    this->queuedChunks = queuedChunks;
+}
+
+void StreamWriter::
+add_properties_to_element(const std::string& elementKey,
+                          const std::vector<std::string>& propertyKeys,
+                          const impl::Type type,
+                          const impl::Type listType,
+                          const size_t listCount)
+{
+    if (out)
+        throw std::logic_error("properties must be declared before "
+                               "the records are appended");
+    if (listType != impl::Type::INVALID && !listCount)
+        throw std::invalid_argument("streamed lists need a fixed `listCount`");
+
+    // Header::write emits only the properties that have user data.
+    for (auto& key: propertyKeys) {
+        impl::ParsingHelper helper;
+        helper.data = std::make_shared<impl::Data>(
+            type, 0, listType != impl::Type::INVALID
+        );
+        header.userData.insert(elementKey, key, std::move(helper));
+    }
+
+    auto e = header.find_element(elementKey);
+    if (!e)
+        e = &header.elements.emplace_back(elementKey, 0);
+    e->create_properties(propertyKeys, type, listType, listCount);
+}
+
+void StreamWriter::
+write_header()
+{
+    for (const auto& e: header.elements) {
+
+        auto& layout = layouts.emplace_back(&e);
+        layout.fixed = true;
+        for (const auto& p: e.properties) {
+
+            impl::FieldSource f {&p};
+            f.info = &impl::types.at(p.scalarType);
+            f.out = f.info;
+            if (p.is_list()) {
+                f.count = p.listCount;
+                f.listStride = impl::types.at(p.listType).stride;
+                impl::FileOut::check_list_lengths(f, 0);
+            }
+            f.bytes = f.count * f.info->stride;
+            layout.recordBytes += f.listStride + f.bytes;
+            layout.fields.push_back(f);
+        }
+    }
+
+    header.write(*os, countWidth);
+    out.emplace(*os, impl::ChunkWriter::defaultChunkSize, queuedChunks);
+}
+
+void StreamWriter::
+append(const std::string& elementKey,
+       const size_t count,
+       uint8_t const* records)
+{
+    if (closed)
+        throw std::logic_error("cannot append to a closed writer");
+    if (!out)
+        write_header();
+
+    size_t k {};
+    while (k < header.elements.size() && header.elements[k].name != elementKey)
+        ++k;
+    if (k == header.elements.size())
+        throw std::invalid_argument("undeclared element '" + elementKey + "'");
+    if (k < current)
+        throw std::logic_error("element '" + elementKey + "' is appended "
+                               "after the element following it");
+    current = k;
+
+    // Point the fields into the packed user records.
+    auto layout = layouts[k];
+    size_t recordBytes {};
+    for (const auto& f: layout.fields)
+        recordBytes += f.bytes;
+
+    size_t offset {};
+    for (auto& f: layout.fields) {
+        f.data = records + offset;
+        f.stride = recordBytes;
+        offset += f.bytes;
+    }
+
+    if (!header.isBinary)
+        impl::FileOut::write_ascii_records(*out, layout, 0, count);
+    else if (recordBytes == layout.recordBytes)  // no list counts to insert
+        out->append(records, count * recordBytes);
+    else
+        impl::FileOut::write_binary_records(*out, layout, 0, count);
+
+    header.elements[k].size += count;
+}
+
+void StreamWriter::
+close()
+{
+    if (closed)
+        return;
+    closed = true;
+
+    if (!out)
+        write_header();
+    out->flush();
+
+    // The header keeps its length, so it is rewritten over the old one.
+    const auto end = os->tellp();
+    os->seekp(start);
+    header.write(*os, countWidth);
+    os->seekp(end);
+    os->flush();
+
+    if (os->fail())
+        throw std::runtime_error("failed to write the element counts");
+
+    if (file)
+        file->close();
+}
+
+}  // namespace tinyply
+
+#endif  // TINYPLY_AS_LIBRARY
+#endif  // TINYPLY_STREAM_WRITER_H
@@ -21,5 +21,10 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include "batch_reader.h"
 #include "reader.h"
+#include "schema.h"
+#include "sequence_reader.h"
+#include "stream_writer.h"
+#include "transcoder.h"
 #include "writer.h"
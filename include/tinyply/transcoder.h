@@ -0,0 +1,313 @@
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TINYPLY_TRANSCODER_H
+#define TINYPLY_TRANSCODER_H
+
+#include "impl/byte_source.h"
+#include "impl/chunk_writer.h"
+#include "impl/header.h"
+#include "impl/interleave.h"
+#include "impl/types.h"
+
+#include <algorithm>
+#include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
+#include <cstring>  // memcpy
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>  // error_code
+#include <vector>
+
+namespace tinyply {
+
+    enum class Encoding: uint8_t {
+
+        ASCII,
+        BINARY_LITTLE_ENDIAN,
+        BINARY_BIG_ENDIAN,
+    };
+
+    /**
+     * The encoding named as in a ply header or on a command line: `ascii`,
+     * `binary_little_endian` (or `binary`) and `binary_big_endian`.
+     * Throws std::invalid_argument for other names.
+     */
+    Encoding encoding_from_name(std::string_view name);
+
+    /**
+     * Converts the ply file pulled from `source` to `encoding`, record by
+     * record, keeping all elements, properties, comments and obj_info.
+     * Memory stays bounded by the buffers of the source and the output,
+     * whatever the size of the file. Binary elements without lists are
+     * copied in blocks of records, swapping the byte order if it changes.
+     */
+    void transcode(ByteSource& source,
+                   std::ostream& os,
+                   Encoding encoding);
+
+    /**
+     * Same as above between files. The output is written to a temporary
+     * file next to `to` and renamed over it once complete, so `to` may
+     * be `from`.
+     */
+    void transcode(const std::filesystem::path& from,
+                   const std::filesystem::path& to,
+                   Encoding encoding);
+
+}  // namespace tinyply
+
+namespace tinyply::impl {
+
+    /**
+     * Reads values in the encoding of the source file
+     * and writes them in that of the output.
+     */
+    struct Transcoder {
+
+        ByteReader& in;
+        ChunkWriter& out;
+
+        bool fromBinary {};
+        bool fromBigEndian {};
+        bool toBinary {};
+        bool toBigEndian {};
+
+        void element(const Element& e);
+        void records(const Element& e);
+        void blocks(const Element& e);
+
+        // In native byte order into `dst`.
+        void read_value(const Info& info,
+                        uint8_t* dst);
+        void write_value(const Info& info,
+                         const uint8_t* src);
+    };
+
+}  // namespace tinyply::impl
+
+
+// IMPLEMENTATION ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+#ifdef TINYPLY_AS_LIBRARY
+
+namespace tinyply::impl {
+
+void Transcoder::
+read_value(const Info& info,
+           uint8_t* dst)
+{
+    if (fromBinary) {
+        if (in.read(dst, info.stride) != size_t(info.stride))
+            throw std::runtime_error("unexpected EOF. malformed file?");
+        if (fromBigEndian)
+            swap_strided(dst, 0, 1, 1, info.stride);
+        return;
+    }
+
+    const auto token = in.token();
+    if (token.empty())
+        throw std::runtime_error("unexpected EOF. malformed file?");
+    if (!info.from_chars(token, dst))
+        throw std::runtime_error("malformed " + std::string(info.str) +
+                                 " value: " + std::string(token));
+}
+
+void Transcoder::
+write_value(const Info& info,
+            const uint8_t* src)
+{
+    if (toBinary) {
+        uint8_t* dst = out.reserve(info.stride);
+        std::memcpy(dst, src, info.stride);
+        if (toBigEndian)
+            swap_strided(dst, 0, 1, 1, info.stride);
+        out.commit(info.stride);
+        return;
+    }
+
+    auto* const first = reinterpret_cast<char*>(out.reserve(maxAsciiChars));
+    auto* last = info.to_chars(first, first + maxAsciiChars, src);
+    *last++ = ' ';
+    out.commit(last - first);
+}
+
+void Transcoder::
+element(const Element& e)
+{
+    const bool lists = std::any_of(e.properties.begin(), e.properties.end(),
+                                   [](const auto& p) { return p.is_list(); });
+    if (fromBinary && toBinary && !lists)
+        blocks(e);
+    else
+        records(e);
+}
+
+void Transcoder::
+records(const Element& e)
+{
+    uint8_t value[sizeof(double)];
+
+    for (size_t i {}; i < e.size; ++i) {
+        for (const auto& p: e.properties) {
+
+            const Info& info = types.at(p.scalarType);
+            size_t n {1};
+
+            if (p.is_list()) {
+                uint8_t count[sizeof(uint32_t)];
+                const Info& countInfo = types.at(p.listType);
+                read_value(countInfo, count);
+                write_value(countInfo, count);
+                n = load_list_count(p.listType, count);
+            }
+            for (size_t j {}; j < n; ++j) {
+                read_value(info, value);
+                write_value(info, value);
+            }
+        }
+        if (!toBinary) {
+            *out.reserve(1) = '\n';
+            out.commit(1);
+        }
+    }
+}
+
+// Records of fixed size, copied a chunk at a time.
+void Transcoder::
+blocks(const Element& e)
+{
+    size_t recordBytes {};
+    for (const auto& p: e.properties)
+        recordBytes += types.at(p.scalarType).stride;
+    if (!recordBytes)
+        return;
+
+    const size_t perBlock = std::max<size_t>(
+        1, ChunkWriter::defaultChunkSize / recordBytes
+    );
+    for (size_t b {}; b < e.size; b += perBlock) {
+
+        const size_t n = std::min(perBlock, e.size - b);
+        const size_t bytes = n * recordBytes;
+        uint8_t* dst = out.reserve(bytes);
+        if (in.read(dst, bytes) != bytes)
+            throw std::runtime_error("unexpected EOF. malformed file?");
+
+        if (fromBigEndian != toBigEndian)
+            for (size_t at {}; const auto& p: e.properties) {
+                const size_t stride = types.at(p.scalarType).stride;
+                swap_strided(dst + at, recordBytes, n, 1, stride);
+                at += stride;
+            }
+        out.commit(bytes);
+    }
+}
+
+}  // namespace tinyply::impl
+
+namespace tinyply {
+
+Encoding
+encoding_from_name(const std::string_view name)
+{
+    if (name == "ascii")
+        return Encoding::ASCII;
+    if (name == "binary" || name == "binary_little_endian")
+        return Encoding::BINARY_LITTLE_ENDIAN;
+    if (name == "binary_big_endian")
+        return Encoding::BINARY_BIG_ENDIAN;
+
+    throw std::invalid_argument("unknown format " + std::string(name));
+}
+
+void
+transcode(ByteSource& source,
+          std::ostream& os,
+          const Encoding encoding)
+{
+    impl::ByteReader in {source};
+
+    std::string_view line;
+    const auto magic = in.line(line) ? impl::next_token(line) : line;
+    if (magic != "ply" && magic != "PLY")
+        throw std::runtime_error("not a ply file");
+
+    impl::Header header;
+    if (!header.parse(in))
+        throw std::runtime_error("malformed header");
+
+    const bool fromBinary = header.isBinary;
+    const bool fromBigEndian = header.isBigEndian;
+    header.isBinary = encoding != Encoding::ASCII;
+    header.isBigEndian = encoding == Encoding::BINARY_BIG_ENDIAN;
+    header.write(os);
+
+    impl::ChunkWriter out {os};
+    impl::Transcoder t {in, out,
+                        fromBinary, fromBigEndian,
+                        header.isBinary, header.isBigEndian};
+    for (const auto& e: header.elements)
+        t.element(e);
+
+    out.flush();
+    if (os.fail())
+        throw std::runtime_error("failed to write the output");
+}
+
+void
+transcode(const std::filesystem::path& from,
+          const std::filesystem::path& to,
+          const Encoding encoding)
+{
+    std::ifstream is(from, std::ios::binary);
+    if (is.fail())
+        throw std::runtime_error("failed to open " + from.string());
+
+    // Written aside, so that `to` may be `from`.
+    const auto tmp = impl::temporary_path_for(to);
+    try {
+        std::ofstream os(tmp, std::ios::binary);
+        if (os.fail())
+            throw std::runtime_error("failed to open " + tmp.string());
+
+        impl::StreamSource source {is};
+        transcode(source, os, encoding);
+        os.close();
+        if (os.fail())
+            throw std::runtime_error("failed to write " + tmp.string());
+    }
+    catch (...) {
+        std::error_code ec;
+        std::filesystem::remove(tmp, ec);
+        throw;
+    }
+    std::filesystem::rename(tmp, to);
+}
+
+}  // namespace tinyply
+
+#endif  // TINYPLY_AS_LIBRARY
+#endif  // TINYPLY_TRANSCODER_H
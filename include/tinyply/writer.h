@@ -28,11 +28,14 @@
 #include "impl/element.h"
 #include "impl/file_out.h"
 #include "impl/types.h"
+#include "schema.h"
 
 #include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -54,8 +57,72 @@ namespace tinyply {
         void write(const std::filesystem::path& p,
                    bool asBinary);
 
+        /**
+         * Writes the file on another thread, returning at once. The data
+         * added to the writer must stay alive and unchanged, and the writer
+         * unused, until the returned future is ready.
+         */
+        std::future<void> write_async(const std::filesystem::path& p,
+                                      bool asBinary);
+
+        /**
+         * Exact size of the binary output in bytes, header included, for
+         * allocating the buffer given to `write_binary` once.
+         */
+        size_t binary_size();
+
+        /**
+         * Writes binary output into a buffer of the caller, e.g. a message
+         * payload, returning the number of bytes written. Throws
+         * std::length_error if the buffer is smaller than `binary_size()`.
+         */
+        size_t write_binary(std::span<std::byte> dst);
+
+        /**
+         * Writes the output into a byte buffer handed over to the caller,
+         * without going through a stream. Binary output is allocated once.
+         */
+        std::vector<uint8_t> write_to_memory(bool asBinary);
+
+        /**
+         * Writes `to` as a copy of the binary ply file `from` in which the
+         * elements added to this writer replace those of the same name,
+         * e.g. recomputed vertex colors next to unchanged faces. The other
+         * elements are copied as they are, by the kernel where it can
+         * (copy_file_range), without being decoded. Elements not in `from`
+         * are appended; comments and obj_info are kept and extended by those
+         * of the writer. The output keeps the byte order of `from`. It is
+         * written to a temporary file next to `to` and renamed over it once
+         * complete, so `to` may be `from`.
+         */
+        void rewrite(const std::filesystem::path& from,
+                     const std::filesystem::path& to);
+
         bool is_binary() const noexcept;
 
+        /**
+         * Number of threads formatting ascii output, one by default;
+         * zero selects the number of hardware threads. With more than one,
+         * binary files written to a path are filled through a memory map
+         * where available. The output does not depend on the number of threads.
+         */
+        void set_num_threads(size_t numThreads) noexcept;
+
+        /**
+         * Writes binary output as `binary_big_endian`, swapping the byte
+         * order of the values and list counts on output. Little-endian
+         * by default.
+         */
+        void set_big_endian(bool bigEndian) noexcept;
+
+        /**
+         * Hands full output chunks to a background thread writing them to
+         * the stream, so that encoding overlaps with the disk writes;
+         * up to `queuedChunks` chunks of 4 MiB wait to be written. Zero,
+         * the default, writes on the calling thread.
+         */
+        void set_write_behind(size_t queuedChunks) noexcept;
+
         void add_comment(const std::string& str) noexcept;
 
         impl::Element& add_element(const std::string& elementKey) noexcept;
@@ -76,6 +143,98 @@ namespace tinyply {
             impl::Type listType,
             size_t listCount
         );
+
+        /**
+         * As above, but reading the properties out of larger records, e.g.
+         * an array of structs: record `i` starts at `data + i * stride`
+         * and holds the value of `propertyKeys[k]` at byte `offsets[k]`.
+         */
+        void add_properties_to_element(
+            const std::string& elementKey,
+            const std::vector<std::string>& propertyKeys,
+            impl::Type type,
+            size_t count,
+            uint8_t const* data,
+            size_t stride,
+            const std::vector<size_t>& offsets,
+            impl::Type listType,
+            size_t listCount
+        );
+
+        /**
+         * Adds properties of different types from one array of records:
+         * record `i` starts at `data + i * stride`, and each field gives the
+         * name, type and byte offset of a property in the record, e.g.
+         * `{{"x", Type::FLOAT32, offsetof(Vertex, x)}, ...}`.
+         */
+        void add_record_to_element(
+            const std::string& elementKey,
+            size_t count,
+            uint8_t const* data,
+            size_t stride,
+            const std::vector<Field>& fields
+        );
+
+        /**
+         * Same as above for a struct bound with TINYPLY_BIND.
+         */
+        template<Bound T>
+        void add_record_to_element(const std::string& elementKey,
+                                   const size_t count,
+                                   T const* records)
+        {
+            add_record_to_element(elementKey,
+                                  count,
+                                  reinterpret_cast<uint8_t const*>(records),
+                                  sizeof(T),
+                                  impl::fields_of<T>());
+        }
+
+        /**
+         * As above, but with the values of each property in a separate
+         * array, `data[k]` holding those of `propertyKeys[k]`. For a single
+         * property, `std::vector {ptr}` selects this overload where `{ptr}`
+         * would not.
+         */
+        void add_properties_to_element(
+            const std::string& elementKey,
+            const std::vector<std::string>& propertyKeys,
+            impl::Type type,
+            size_t count,
+            const std::vector<uint8_t const*>& data,
+            impl::Type listType,
+            size_t listCount
+        );
+
+        /**
+         * Writes the properties as `type` rather than as the type they
+         * were added with, converting the values on output. Values are
+         * first multiplied by `scale`, e.g. 255 for colors in [0, 1]
+         * written as uchar. Conversions to integer types round to nearest
+         * and saturate. List counts keep their type.
+         */
+        void set_output_type(
+            const std::string& elementKey,
+            const std::vector<std::string>& propertyKeys,
+            impl::Type type,
+            double scale = 1
+        );
+
+        /**
+         * Adds a list property whose lists may differ in length, e.g. the
+         * faces of a polygon mesh. The lists are stored back to back in
+         * `values`; the list of record `i` spans the values from `offsets[i]`
+         * to `offsets[i+1]`, so that `offsets` holds `count + 1` entries.
+         */
+        void add_list_property_to_element(
+            const std::string& elementKey,
+            const std::string& propertyKey,
+            impl::Type type,
+            size_t count,
+            uint8_t const* values,
+            impl::Type listType,
+            size_t const* offsets
+        );
     };
 
     using FileOut = Writer;
@@ -107,12 +266,64 @@ write(const std::filesystem::path& p,
     return file->write(p, asBinary);
 }
 
+std::future<void> Writer::
+write_async(const std::filesystem::path& p,
+            const bool asBinary)
+{
+    return std::async(std::launch::async, [this, p, asBinary] {
+        file->write(p, asBinary);
+    });
+}
+
+size_t Writer::
+binary_size()
+{
+    return file->binary_size();
+}
+
+size_t Writer::
+write_binary(std::span<std::byte> dst)
+{
+    return file->write_binary(dst);
+}
+
+std::vector<uint8_t> Writer::
+write_to_memory(const bool asBinary)
+{
+    return file->write_to_memory(asBinary);
+}
+
+void Writer::
+rewrite(const std::filesystem::path& from,
+        const std::filesystem::path& to)
+{
+    return file->rewrite(from, to);
+}
+
 void Writer::
 add_comment(const std::string& str) noexcept
 {
     file->header.comments.push_back(str);
 }
 
+void Writer::
+set_num_threads(const size_t numThreads) noexcept
+{
+    file->numThreads = numThreads;
+}
+
+void Writer::
+set_big_endian(const bool bigEndian) noexcept
+{
+    file->bigEndian = bigEndian;
+}
+
+void Writer::
+set_write_behind(const size_t queuedChunks) noexcept
+{
+    file->queuedChunks = queuedChunks;
+}
+
 bool Writer::
 is_binary() const noexcept
 {
@@ -143,6 +354,83 @@ add_properties_to_element(const std::string& elementKey,
                                            listCount);
 }
 
+void Writer::
+add_properties_to_element(const std::string& elementKey,
+                          const std::vector<std::string>& propertyKeys,
+                          const impl::Type type,
+                          const size_t count,
+                          uint8_t const* data,
+                          const size_t stride,
+                          const std::vector<size_t>& offsets,
+                          const impl::Type listType,
+                          const size_t listCount)
+{
+    return file->add_properties_to_element(elementKey,
+                                           propertyKeys,
+                                           type,
+                                           count,
+                                           data,
+                                           stride,
+                                           offsets,
+                                           listType,
+                                           listCount);
+}
+
+void Writer::
+add_properties_to_element(const std::string& elementKey,
+                          const std::vector<std::string>& propertyKeys,
+                          const impl::Type type,
+                          const size_t count,
+                          const std::vector<uint8_t const*>& data,
+                          const impl::Type listType,
+                          const size_t listCount)
+{
+    return file->add_properties_to_element(elementKey,
+                                           propertyKeys,
+                                           type,
+                                           count,
+                                           data,
+                                           listType,
+                                           listCount);
+}
+
+void Writer::
+add_record_to_element(const std::string& elementKey,
+                      const size_t count,
+                      uint8_t const* data,
+                      const size_t stride,
+                      const std::vector<Field>& fields)
+{
+    return file->add_record_to_element(elementKey, count, data, stride, fields);
+}
+
+void Writer::
+set_output_type(const std::string& elementKey,
+                const std::vector<std::string>& propertyKeys,
+                const impl::Type type,
+                const double scale)
+{
+    return file->set_output_type(elementKey, propertyKeys, type, scale);
+}
+
+void Writer::
+add_list_property_to_element(const std::string& elementKey,
+                             const std::string& propertyKey,
+                             const impl::Type type,
+                             const size_t count,
+                             uint8_t const* values,
+                             const impl::Type listType,
+                             size_t const* offsets)
+{
+    return file->add_list_property_to_element(elementKey,
+                                              propertyKey,
+                                              type,
+                                              count,
+                                              values,
+                                              listType,
+                                              offsets);
+}
+
 }  // namespace tinyply
 
 #endif  // TINYPLY_AS_LIBRARY
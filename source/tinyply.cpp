@@ -28,5 +28,9 @@
 // directly into your project and define this:
 #define TINYPLY_AS_LIBRARY
 
+#include "batch_reader.h"
 #include "reader.h"
+#include "sequence_reader.h"
+#include "stream_writer.h"
+#include "transcoder.h"
 #include "writer.h"
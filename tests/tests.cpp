@@ -32,10 +32,14 @@
 
 #include "../examples/utils.h"
 #include "../tinyply/tinyply.h"
+#include "../tools/plytool.h"
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
 
+#include <algorithm>
+#include <cstddef>  // offsetof
+#include <sstream>
 #include <string>
 
 namespace tinyply::tests::doc {
@@ -286,6 +290,1516 @@ TEST_CASE("check that variable length lists are unsupported (without crashing)")
     variable_length_test("../assets/validate/valid/kcrane.city.ply");
 }
 
+TEST_CASE("reading stops after the last element with requested properties")
+{
+    const std::string header {
+        "element vertex 2\n"
+        "property float x\n"
+        "element face 2\n"
+        "property list uchar int vertex_indices\n"
+        "end_header\n"
+    };
+
+    // The faces are garbage in the ascii file and truncated in the binary one.
+    std::istringstream ascii("ply\nformat ascii 1.0\n" + header + "1.5\n-2\n3 0 x\n");
+    impl::FileIn file;
+    REQUIRE(file.header.parse(ascii));
+    auto x = file.request_properties_from_element("vertex", {"x"});
+    REQUIRE_NOTHROW(file.read(ascii));
+    CHECK(x->as_span<float>()[0] == 1.5f);
+    CHECK(x->as_span<float>()[1] == -2.f);
+
+    std::string bytes {"ply\nformat binary_little_endian 1.0\n" + header};
+    const float values[] {1.5f, -2.f};
+    bytes.append(reinterpret_cast<const char*>(values), sizeof(values));
+    bytes += '\3';
+    std::istringstream binary(bytes);
+    impl::FileIn file2;
+    REQUIRE(file2.header.parse(binary));
+    x = file2.request_properties_from_element("vertex", {"x"});
+    REQUIRE_NOTHROW(file2.read(binary));
+    CHECK(x->as_span<float>()[1] == -2.f);
+
+    // The stream is left right after the vertices.
+    CHECK(binary.tellg() == std::streamoff(bytes.size() - 1));
+}
+
+TEST_CASE("malformed ascii values throw")
+{
+    const std::string header {
+        "ply\nformat ascii 1.0\n"
+        "element vertex 2\n"
+        "property float x\n"
+        "property uchar tag\n"
+        "end_header\n"
+    };
+
+    // A leading '+' is accepted, as by the stream operators.
+    std::istringstream valid(header + "+1.5 +7\n-2 255\n");
+    impl::FileIn file;
+    REQUIRE(file.header.parse(valid));
+    const auto x = file.request_properties_from_element("vertex", {"x"});
+    const auto tag = file.request_properties_from_element("vertex", {"tag"});
+    file.read(valid);
+    CHECK(x->as_span<float>()[0] == 1.5f);
+    CHECK(tag->as_span<uint8_t>()[0] == 7);
+    CHECK(tag->as_span<uint8_t>()[1] == 255);
+
+    for (const std::string values: {"1.5 7\n-2y 1\n", "1.5 7\nx 1\n", "1.5 7\n-2 256\n"}) {
+        std::istringstream is(header + values);
+        impl::FileIn malformed;
+        REQUIRE(malformed.header.parse(is));
+        malformed.request_properties_from_element("vertex", {"x"});
+        malformed.request_properties_from_element("vertex", {"tag"});
+        CHECK_THROWS_AS(malformed.read(is), std::runtime_error);
+    }
+}
+
+TEST_CASE("read plan reports exact buffer sizes before reading")
+{
+    std::istringstream is(
+        "ply\n"
+        "format ascii 1.0\n"
+        "element vertex 3\n"
+        "property float x\n"
+        "property float y\n"
+        "property uchar red\n"
+        "element face 1\n"
+        "property list uchar int vertex_indices\n"
+        "end_header\n"
+        "0 0 1\n1 0 2\n0 1 3\n"
+        "3 0 1 2\n"
+    );
+    impl::FileIn file;
+    REQUIRE(file.header.parse(is));
+
+    auto xy = file.request_properties_from_element("vertex", {"x", "y"});
+    auto red = file.request_properties_from_element("vertex", {"red"});
+
+    auto plan = file.plan();
+    REQUIRE(plan.groups.size() == 2);
+    CHECK(plan.groups[0].data == xy);
+    CHECK(plan.groups[0].bytes == 3 * 2 * sizeof(float));
+    CHECK(plan.groups[1].bytes == 3);
+    CHECK(plan.totalBytes == 27);
+    CHECK_FALSE(plan.countingPass);
+
+    auto faces = file.request_properties_from_element("face", {"vertex_indices"});
+    plan = file.plan();
+    CHECK_FALSE(plan.groups[2].exact);
+    CHECK(plan.countingPass);
+
+    file.read(is);
+    CHECK(xy->buffer.size_bytes() == 24);
+    CHECK(faces->buffer.size_bytes() == 3 * sizeof(int32_t));
+}
+
+TEST_CASE("header parsing from memory")
+{
+    std::string text {"ply\nformat binary_big_endian 1.0\ncomment a b\n"};
+    constexpr size_t numProperties {1000};
+    text += "element vertex 7\r\n";
+    for (size_t i {}; i < numProperties; ++i)
+        text += "property float p" + std::to_string(i) + "\n";
+    text += "element face 2\nproperty list uchar uint vertex_indices\n";
+    text += "end_header\n";
+    const size_t headerBytes = text.size();
+    text += "payload";
+
+    Header header;
+    REQUIRE(header.parse(text));
+    CHECK(header.headerBytes == headerBytes);
+    CHECK(header.isBigEndian);
+    CHECK(header.comments.front() == "a b");
+    REQUIRE(header.elements.size() == 2);
+    CHECK(header.elements[0].size == 7);
+    CHECK(header.elements[0].properties.size() == numProperties);
+    CHECK(header.elements[1].properties[0].listType == Type::UINT8);
+    CHECK(header.elements[1].properties[0].scalarType == Type::UINT32);
+
+    for (const std::string_view bad: {"abc", "-1", "7x", "", "99999999999999999999999"}) {
+        Header h;
+        CHECK_THROWS_AS(h.parse("ply\nformat ascii 1.0\nelement vertex " +
+                                std::string(bad) + "\nend_header\n"),
+                        std::runtime_error);
+    }
+}
+
+TEST_CASE("batch reader returns the requested data of every file")
+{
+    const auto dir = std::filesystem::temp_directory_path() / "tinyply-batch";
+    std::filesystem::create_directories(dir);
+
+    std::vector<std::filesystem::path> paths;
+    for (int i {}; i < 10; ++i) {
+        paths.push_back(dir / ("points" + std::to_string(i) + ".ply"));
+        std::ofstream os(paths.back());
+        os << "ply\nformat ascii 1.0\nelement vertex " << i + 1
+           << "\nproperty int x\nproperty int y\nend_header\n";
+        for (int j {}; j <= i; ++j)
+            os << i << " " << j << "\n";
+    }
+    paths.push_back(dir / "partial.ply");
+    std::ofstream(paths.back()) << "ply\nformat ascii 1.0\nelement vertex 1\n"
+                                   "property int x\nend_header\n7\n";
+    paths.push_back(dir / "missing.ply");
+
+    BatchReader reader({{"vertex", {"x", "y"}}, {"face", {"vertex_indices"}}}, 3);
+
+    const auto results = reader.read(paths);
+    REQUIRE(results.size() == paths.size());
+    for (int i {}; i < 10; ++i) {
+        REQUIRE(results[i].data.size() == 2);
+        const auto& d = *results[i].data[0];
+        CHECK(d.count == i + 1);
+        CHECK(reinterpret_cast<const int32_t*>(d.buffer.get())[2 * i + 1] == i);
+        CHECK(!results[i].data[1]);
+        CHECK(results[i].skipped == std::vector<std::string> {"element face not found"});
+    }
+
+    // Missing properties are left out of their request and reported.
+    const auto& partial = results[10];
+    REQUIRE(partial.data[0]);
+    CHECK(reinterpret_cast<const int32_t*>(partial.data[0]->buffer.get())[0] == 7);
+    CHECK(partial.skipped.size() == 2);
+    CHECK(partial.skipped[0] == "property y not found in the element vertex");
+
+    CHECK(results.back().error);
+
+    size_t numResults {};
+    reader.read(paths, [&](BatchReader::Result&& r) {
+        CHECK(r.path == paths[r.index]);
+        numResults++;
+    });
+    CHECK(numResults == paths.size());
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("sequence reader keeps buffers from frame to frame")
+{
+    const auto dir = std::filesystem::temp_directory_path() / "tinyply-sequence";
+    std::filesystem::create_directories(dir);
+
+    const std::vector<int> sizes {4, 3, 2, 5};
+    std::vector<std::filesystem::path> paths;
+    for (size_t i {}; i < sizes.size(); ++i) {
+        paths.push_back(dir / ("frame" + std::to_string(i) + ".ply"));
+        std::ofstream os(paths.back());
+        os << "ply\nformat ascii 1.0\nelement vertex " << sizes[i]
+           << "\nproperty float x\nelement face 1"
+           << "\nproperty list uchar int vertex_indices\nend_header\n";
+        for (int j {}; j < sizes[i]; ++j)
+            os << i + 0.5 * j << "\n";
+        os << "3 0 1 " << i << "\n";
+    }
+
+    SequenceReader reader(paths, {{"vertex", {"x"}}, {"face", {"vertex_indices"}}});
+
+    std::vector<const uint8_t*> buffers;
+    for (size_t i {}; i < sizes.size(); ++i) {
+        const auto frame = reader.next();
+        REQUIRE(frame);
+        CHECK(frame->index == i);
+        const auto& x = *frame->data[0];
+        CHECK(x.count == sizes[i]);
+        CHECK(reinterpret_cast<const float*>(x.buffer.get())[1] == i + 0.5f);
+        CHECK(reinterpret_cast<const int32_t*>(frame->data[1]->buffer.get())[2] == i);
+        buffers.push_back(x.buffer.get());
+    }
+    CHECK_FALSE(reader.next());
+    CHECK(buffers[2] == buffers[0]);  // shrinking frames do not reallocate
+
+    // The second frame is the first of its slot, and still checked.
+    {
+        std::ofstream os(paths[1]);
+        os << "ply\nformat ascii 1.0\nelement vertex 1\nproperty double x\n"
+           << "element face 1\nproperty list uchar int vertex_indices\nend_header\n"
+           << "0\n3 0 1 2\n";
+    }
+    SequenceReader mismatched(paths, {{"vertex", {"x"}}});
+    CHECK(mismatched.next());
+    CHECK_THROWS_AS(mismatched.next(), std::runtime_error);
+
+    // Without requests, frames are still parsed and checked.
+    SequenceReader headersOnly({paths[0], paths[2], paths[3]}, {});
+    for (int i {}; i < 3; ++i)
+        CHECK(headersOnly.next());
+    CHECK_FALSE(headersOnly.next());
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("ascii output round-trips floating point values exactly")
+{
+    const std::vector<double> values {1. / 3., 0.1, -2.5e-300, 123456789.123};
+    const std::vector<uint8_t> colors {0, 128, 255, 7};
+
+    std::stringstream ss;
+    {
+        impl::FileOut file;
+        file.add_properties_to_element(
+            "vertex", {"t"}, Type::FLOAT64, values.size(),
+            reinterpret_cast<uint8_t const*>(values.data()), Type::INVALID, 0
+        );
+        file.add_properties_to_element(
+            "vertex", {"red"}, Type::UINT8, colors.size(),
+            colors.data(), Type::INVALID, 0
+        );
+        file.write(ss, false);
+    }
+
+    impl::FileIn file;
+    REQUIRE(file.header.parse(ss));
+    auto t = file.request_properties_from_element("vertex", {"t"});
+    auto red = file.request_properties_from_element("vertex", {"red"});
+    file.read(ss);
+
+    CHECK(std::memcmp(t->buffer.get(), values.data(), 8 * values.size()) == 0);
+    CHECK(std::memcmp(red->buffer.get(), colors.data(), colors.size()) == 0);
+}
+
+TEST_CASE("ascii output does not depend on the number of threads")
+{
+    const size_t count = 3 * impl::FileOut::recordsPerBlock + 17;
+    std::vector<float> xyz(3 * count);
+    for (size_t i {}; i < xyz.size(); ++i)
+        xyz[i] = i * 0.37f;
+    std::vector<uint32_t> faces(3 * count);
+    for (size_t i {}; i < faces.size(); ++i)
+        faces[i] = static_cast<uint32_t>(i);
+
+    auto write = [&](const size_t numThreads) {
+        impl::FileOut file;
+        file.numThreads = numThreads;
+        file.add_properties_to_element(
+            "vertex", {"x", "y", "z"}, Type::FLOAT32, count,
+            reinterpret_cast<uint8_t const*>(xyz.data()), Type::INVALID, 0
+        );
+        file.add_properties_to_element(
+            "face", {"vertex_indices"}, Type::UINT32, count,
+            reinterpret_cast<uint8_t const*>(faces.data()), Type::UINT8, 3
+        );
+        std::ostringstream os;
+        file.write(os, false);
+        return os.str();
+    };
+
+    const auto serial = write(1);
+    CHECK(write(2) == serial);
+    CHECK(write(5) == serial);
+}
+
+TEST_CASE("variable-length lists are written from offsets and values")
+{
+    const std::vector<float> x {0.f, 1.f, 2.f, 3.f, 4.f};
+    const std::vector<int32_t> indices {0, 1, 2,  0, 2, 3, 4,  1, 2, 3, 4, 0};
+    const std::vector<size_t> offsets {0, 3, 7, 12};
+
+    impl::FileOut file;
+    file.add_properties_to_element(
+        "vertex", {"x"}, Type::FLOAT32, x.size(),
+        reinterpret_cast<uint8_t const*>(x.data()), Type::INVALID, 0
+    );
+    file.add_list_property_to_element(
+        "face", "vertex_indices", Type::INT32, offsets.size() - 1,
+        reinterpret_cast<uint8_t const*>(indices.data()), Type::UINT8,
+        offsets.data()
+    );
+
+    std::ostringstream ascii;
+    file.write(ascii, false);
+    CHECK(ascii.str().ends_with("3 0 1 2 \n4 0 2 3 4 \n5 1 2 3 4 0 \n"));
+
+    std::ostringstream binary;
+    file.write(binary, true);
+    const auto s = binary.str();
+    const auto payload = s.substr(s.find("end_header\n") + 11);
+    REQUIRE(payload.size() == x.size() * 4 + 3 + indices.size() * 4);
+    CHECK(payload[x.size() * 4] == 3);
+    CHECK(payload[x.size() * 4 + 1 + 3 * 4] == 4);
+
+    // A list of 200 fits a uchar count, but not a char one.
+    const std::vector<int32_t> many(200);
+    const std::vector<size_t> whole {0, many.size()};
+    for (const auto& [countType, fits]: {std::pair {Type::UINT8, true},
+                                         std::pair {Type::INT8, false}}) {
+        impl::FileOut longer;
+        longer.add_list_property_to_element(
+            "face", "vertex_indices", Type::INT32, 1,
+            reinterpret_cast<uint8_t const*>(many.data()), countType, whole.data()
+        );
+        std::ostringstream os;
+        if (fits)
+            CHECK_NOTHROW(longer.write(os, true));
+        else
+            CHECK_THROWS_AS(longer.write(os, true), std::runtime_error);
+    }
+
+    // So do fixed lengths.
+    const std::vector<int32_t> wide(300);
+    for (const auto& [countType, fits]: {std::pair {Type::UINT16, true},
+                                         std::pair {Type::UINT8, false}}) {
+        impl::FileOut fixed;
+        fixed.add_properties_to_element(
+            "face", {"vertex_indices"}, Type::INT32, 1,
+            reinterpret_cast<uint8_t const*>(wide.data()), countType, wide.size()
+        );
+        std::ostringstream os;
+        if (fits)
+            CHECK_NOTHROW(fixed.write(os, false));
+        else
+            CHECK_THROWS_AS(fixed.write(os, false), std::runtime_error);
+
+        std::ostringstream ss;
+        StreamWriter streamed {ss, true};
+        streamed.add_properties_to_element("face", {"vertex_indices"}, Type::INT32,
+                                           countType, wide.size());
+        const auto records = reinterpret_cast<uint8_t const*>(wide.data());
+        if (fits)
+            CHECK_NOTHROW(streamed.append("face", 1, records));
+        else
+            CHECK_THROWS_AS(streamed.append("face", 1, records), std::runtime_error);
+    }
+}
+
+TEST_CASE("streamed records match the output of the whole-array writer")
+{
+    struct Vertex { float x, y, z; };
+    struct Face { uint32_t v[3]; };
+
+    std::vector<Vertex> vertices(1000);
+    for (size_t i {}; i < vertices.size(); ++i)
+        vertices[i] = {float(i), 0.5f * i, -0.25f * i};
+    std::vector<Face> faces(500);
+    for (uint32_t i {}; i < faces.size(); ++i)
+        faces[i] = {{i, i + 1, i + 2}};
+
+    for (const bool asBinary: {true, false}) {
+
+        impl::FileOut whole;
+        whole.add_properties_to_element(
+            "vertex", {"x", "y", "z"}, Type::FLOAT32, vertices.size(),
+            reinterpret_cast<uint8_t const*>(vertices.data()), Type::INVALID, 0
+        );
+        whole.add_properties_to_element(
+            "face", {"vertex_indices"}, Type::UINT32, faces.size(),
+            reinterpret_cast<uint8_t const*>(faces.data()), Type::UINT8, 3
+        );
+        std::ostringstream expected;
+        whole.write(expected, asBinary);
+
+        std::stringstream streamed;
+        {
+            StreamWriter writer {streamed, asBinary};
+            writer.add_properties_to_element("vertex", {"x", "y", "z"},
+                                             Type::FLOAT32);
+            writer.add_properties_to_element("face", {"vertex_indices"},
+                                             Type::UINT32, Type::UINT8, 3);
+
+            for (size_t i {}; i < vertices.size(); i += 300) {
+                const auto n = std::min<size_t>(300, vertices.size() - i);
+                writer.append("vertex", n,
+                              reinterpret_cast<uint8_t const*>(&vertices[i]));
+            }
+            writer.append("face", faces.size(),
+                          reinterpret_cast<uint8_t const*>(faces.data()));
+
+            CHECK_THROWS_AS(writer.append("vertex", 1, nullptr),
+                            std::logic_error);
+        }
+
+        const auto a = expected.str();
+        const auto b = streamed.str();
+        CHECK(b.find("element vertex 00000000000000001000\n") != b.npos);
+        CHECK(b.find("element face 00000000000000000500\n") != b.npos);
+
+        const auto payload = [](const std::string& s) {
+            return s.substr(s.find("end_header\n"));
+        };
+        CHECK(payload(a) == payload(b));
+
+        Header h;
+        REQUIRE(h.parse(std::string_view(b)));
+        CHECK(h.elements[0].size == vertices.size());
+        CHECK(h.elements[1].size == faces.size());
+    }
+}
+
+TEST_CASE("binary files written through a memory map match the stream output")
+{
+    const size_t n = 3 * impl::FileOut::recordsPerBlock + 7;
+    std::vector<double> xyz(3 * n);
+    for (size_t i {}; i < xyz.size(); ++i)
+        xyz[i] = 0.1 * i;
+    std::vector<uint16_t> tags(n);
+    for (size_t i {}; i < n; ++i)
+        tags[i] = static_cast<uint16_t>(i);
+    const std::vector<int32_t> indices {0, 1, 2, 3,  4, 5, 6};
+    const std::vector<size_t> offsets {0, 4, 7};
+
+    impl::FileOut file;
+    file.numThreads = 4;
+    file.add_properties_to_element(
+        "vertex", {"x", "y", "z"}, Type::FLOAT64, n,
+        reinterpret_cast<uint8_t const*>(xyz.data()), Type::INVALID, 0
+    );
+    file.add_properties_to_element(
+        "vertex", {"tag"}, Type::UINT16, n,
+        reinterpret_cast<uint8_t const*>(tags.data()), Type::INVALID, 0
+    );
+    file.add_list_property_to_element(
+        "face", "vertex_indices", Type::INT32, offsets.size() - 1,
+        reinterpret_cast<uint8_t const*>(indices.data()), Type::UINT8,
+        offsets.data()
+    );
+
+    std::ostringstream expected;
+    file.write(expected, true);
+
+    const auto path = std::filesystem::temp_directory_path() / "tinyply-mapped.ply";
+    file.write(path, true);
+
+    std::ifstream is(path, std::ios::binary);
+    const std::string written {std::istreambuf_iterator<char>(is), {}};
+    CHECK(written.size() == expected.str().size());
+    CHECK(written == expected.str());
+
+    // Written aside, with nothing left next to the output.
+    for (const auto& entry: std::filesystem::directory_iterator(path.parent_path()))
+        CHECK(!entry.path().filename().string().starts_with("tinyply-mapped.ply.tmp"));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("separate property arrays are written as interleaved records")
+{
+    const size_t n = 1000;
+    std::vector<float> xyz(3 * n), x(n), y(n), z(n);
+    for (size_t i {}; i < n; ++i) {
+        xyz[3*i]   = x[i] = 1.5f * i;
+        xyz[3*i+1] = y[i] = -0.5f * i;
+        xyz[3*i+2] = z[i] = 0.25f * i;
+    }
+    std::vector<uint8_t> labels(n);
+    for (size_t i {}; i < n; ++i)
+        labels[i] = static_cast<uint8_t>(i);
+
+    auto bytes = [](const auto& v) {
+        return reinterpret_cast<uint8_t const*>(v.data());
+    };
+
+    for (const bool asBinary: {true, false}) {
+
+        impl::FileOut aos;
+        aos.add_properties_to_element("vertex", {"x", "y", "z"}, Type::FLOAT32,
+                                      n, bytes(xyz), Type::INVALID, 0);
+        aos.add_properties_to_element("vertex", {"label"}, Type::UINT8,
+                                      n, bytes(labels), Type::INVALID, 0);
+        std::ostringstream expected;
+        aos.write(expected, asBinary);
+
+        impl::FileOut soa;
+        soa.add_properties_to_element("vertex", {"x", "y", "z"}, Type::FLOAT32,
+                                      n, {bytes(x), bytes(y), bytes(z)},
+                                      Type::INVALID, 0);
+        soa.add_properties_to_element("vertex", {"label"}, Type::UINT8,
+                                      n, std::vector {bytes(labels)},
+                                      Type::INVALID, 0);
+        std::ostringstream written;
+        soa.write(written, asBinary);
+
+        CHECK(written.str() == expected.str());
+    }
+
+    impl::FileOut file;
+    CHECK_THROWS_AS(file.add_properties_to_element("vertex", {"x", "y"},
+                                                   Type::FLOAT32, n,
+                                                   std::vector {bytes(x)},
+                                                   Type::INVALID, 0),
+                    std::invalid_argument);
+}
+
+TEST_CASE("properties are read out of padded structs at their offsets")
+{
+    struct Vertex {
+        double unrelated;
+        float position[3];
+        uint32_t id;
+        float normal[3];
+        uint8_t flags;
+    };
+    static_assert(sizeof(Vertex) == 40);
+
+    const size_t n = 500;
+    std::vector<Vertex> vertices(n);
+    std::vector<float> packed;
+    for (size_t i {}; i < n; ++i) {
+        auto& v = vertices[i];
+        v = {-1.0, {1.f * i, 2.f * i, 3.f * i}, 0xdeadbeef, {0.f, 0.f, 1.f}, 7};
+        packed.insert(packed.end(), v.position, v.position + 3);
+        packed.insert(packed.end(), v.normal, v.normal + 3);
+    }
+
+    for (const bool asBinary: {true, false}) {
+
+        impl::FileOut strided;
+        strided.add_properties_to_element(
+            "vertex", {"x", "y", "z", "nx", "ny", "nz"}, Type::FLOAT32, n,
+            reinterpret_cast<uint8_t const*>(vertices.data()), sizeof(Vertex),
+            {offsetof(Vertex, position), offsetof(Vertex, position) + 4,
+             offsetof(Vertex, position) + 8, offsetof(Vertex, normal),
+             offsetof(Vertex, normal) + 4, offsetof(Vertex, normal) + 8},
+            Type::INVALID, 0
+        );
+        std::ostringstream written;
+        strided.write(written, asBinary);
+
+        impl::FileOut tight;
+        tight.add_properties_to_element(
+            "vertex", {"x", "y", "z", "nx", "ny", "nz"}, Type::FLOAT32, n,
+            reinterpret_cast<uint8_t const*>(packed.data()), Type::INVALID, 0
+        );
+        std::ostringstream expected;
+        tight.write(expected, asBinary);
+
+        CHECK(written.str() == expected.str());
+    }
+
+    impl::FileOut file;
+    CHECK_THROWS_AS(file.add_properties_to_element(
+                        "vertex", {"flags"}, Type::UINT16, n,
+                        reinterpret_cast<uint8_t const*>(vertices.data()),
+                        sizeof(Vertex), {sizeof(Vertex) - 1},
+                        Type::INVALID, 0),
+                    std::invalid_argument);
+}
+
+struct ScanPoint {
+    float x, y, z;
+    uint16_t intensity;
+    uint8_t returns;
+    uint8_t pad;
+};
+
+struct ScanFace {
+    uint32_t vertices[3];
+};
+
+// The same properties as ScanPoint, in a different memory layout.
+struct ScanSample {
+    double unused;
+    uint16_t intensity;
+    float position[3];
+};
+
+TINYPLY_BIND(ScanPoint,
+             TINYPLY_FIELD(x, "x"),
+             TINYPLY_FIELD(y, "y"),
+             TINYPLY_FIELD(z, "z"),
+             TINYPLY_FIELD(intensity, "intensity"),
+             TINYPLY_FIELD(returns, "returns"),
+             TINYPLY_FIELD(pad, "pad"));
+
+TINYPLY_BIND(ScanFace,
+             TINYPLY_FIELD(vertices, "vertex_indices"));
+
+TINYPLY_BIND(ScanSample,
+             TINYPLY_FIELD(position[0], "x"),
+             TINYPLY_FIELD(position[1], "y"),
+             TINYPLY_FIELD(position[2], "z"),
+             TINYPLY_FIELD(intensity, "intensity"));
+
+TEST_CASE("structs bound at compile time are written and read back")
+{
+    static_assert(type_of<uint16_t> == Type::UINT16);
+    static_assert(Schema<ScanFace>::fields[0].listCount == 3);
+
+    std::vector<ScanPoint> points(1000);
+    for (size_t i {}; i < points.size(); ++i)
+        points[i] = {1.f * i, 2.f * i, 3.f * i, uint16_t(7 * i), uint8_t(i % 5), 0};
+    const std::vector<ScanFace> faces {{{0, 1, 2}}, {{2, 1, 3}}};
+
+    for (const int format: {0, 1, 2}) {  // ascii, little and big endian
+
+        Writer writer;
+        writer.add_record_to_element("vertex", points.size(), points.data());
+        writer.add_record_to_element("face", faces.size(), faces.data());
+        writer.file->bigEndian = format == 2;
+        std::ostringstream os;
+        writer.file->write(os, format != 0);
+        CHECK(os.str().find("property list uchar uint vertex_indices\n")
+              != std::string::npos);
+
+        std::istringstream is(os.str());
+        Reader reader;
+        REQUIRE(reader.parse_header(is));
+        const auto p = reader.request_record_from_element<ScanPoint>("vertex");
+        const auto f = reader.request_record_from_element<ScanFace>("face");
+        reader.read(is);
+
+        REQUIRE(p->buffer.size_bytes() == points.size() * sizeof(ScanPoint));
+        CHECK(std::memcmp(p->buffer.get(), points.data(), p->buffer.size_bytes()) == 0);
+        REQUIRE(f->buffer.size_bytes() == faces.size() * sizeof(ScanFace));
+        CHECK(std::memcmp(f->buffer.get(), faces.data(), f->buffer.size_bytes()) == 0);
+
+        std::istringstream is2(os.str());
+        Reader other;
+        REQUIRE(other.parse_header(is2));
+        const auto s = other.request_record_from_element<ScanSample>("vertex");
+        other.read(is2);
+
+        const auto* samples = reinterpret_cast<const ScanSample*>(s->buffer.get());
+        for (size_t i {}; i < points.size(); ++i) {
+            CHECK(samples[i].position[1] == points[i].y);
+            CHECK(samples[i].intensity == points[i].intensity);
+        }
+    }
+
+    // The types of the struct are checked against the file.
+    std::istringstream is("ply\nformat ascii 1.0\nelement vertex 1\n"
+                          "property double x\nproperty double y\n"
+                          "property double z\nproperty ushort intensity\n"
+                          "end_header\n1 2 3 4\n");
+    Reader reader;
+    REQUIRE(reader.parse_header(is));
+    CHECK_THROWS_AS(reader.request_record_from_element<ScanSample>("vertex"),
+                    std::invalid_argument);
+
+    // So are the list lengths, by the decode loop of the struct.
+    const std::vector<uint32_t> quads {0, 1, 2, 3};
+    Writer quadWriter;
+    quadWriter.add_properties_to_element("face", {"vertex_indices"}, Type::UINT32, 1,
+                                         reinterpret_cast<uint8_t const*>(quads.data()),
+                                         Type::UINT8, 4);
+    std::ostringstream quad;
+    quadWriter.file->write(quad, true);
+    std::istringstream quadIn(quad.str());
+    Reader quadReader;
+    REQUIRE(quadReader.parse_header(quadIn));
+    quadReader.request_record_from_element<ScanFace>("face");
+    CHECK_THROWS_AS(quadReader.read(quadIn), std::runtime_error);
+
+    // Records holding lists not in the struct are not of fixed size.
+    const std::vector<uint8_t> tags(2 * points.size(), 9);
+    Writer tagged;
+    tagged.add_record_to_element("vertex", points.size(), points.data());
+    tagged.add_properties_to_element("vertex", {"tags"}, Type::UINT8, points.size(),
+                                     tags.data(), Type::UINT8, 2);
+    std::ostringstream os;
+    tagged.file->write(os, true);
+    std::istringstream taggedIn(os.str());
+    Reader taggedReader;
+    REQUIRE(taggedReader.parse_header(taggedIn));
+    const auto s = taggedReader.request_record_from_element<ScanSample>("vertex");
+    taggedReader.read(taggedIn);
+    CHECK(s->as_span<ScanSample>()[999].position[2] == points[999].z);
+}
+
+TEST_CASE("values are converted to the declared output type")
+{
+    const std::vector<double> xyz {0.1, -2.5, 1e300,  3.0, 4.0, 5.0};
+    const std::vector<float> rgb {0.f, 0.5f, 1.2f,  1.f, -0.1f, 0.25f};
+    const std::vector<uint32_t> indices {1, 70000, 0};
+
+    auto bytes = [](const auto& v) {
+        return reinterpret_cast<uint8_t const*>(v.data());
+    };
+
+    impl::FileOut file;
+    file.add_properties_to_element("vertex", {"x", "y", "z"}, Type::FLOAT64,
+                                   2, bytes(xyz), Type::INVALID, 0);
+    file.add_properties_to_element("vertex", {"red", "green", "blue"},
+                                   Type::FLOAT32, 2, bytes(rgb),
+                                   Type::INVALID, 0);
+    file.add_properties_to_element("face", {"vertex_indices"}, Type::UINT32,
+                                   1, bytes(indices), Type::UINT8, 3);
+    file.set_output_type("vertex", {"x", "y", "z"}, Type::FLOAT32, 1);
+    file.set_output_type("vertex", {"red", "green", "blue"}, Type::UINT8, 255);
+    file.set_output_type("face", {"vertex_indices"}, Type::UINT16, 1);
+
+    CHECK_THROWS_AS(file.set_output_type("vertex", {"w"}, Type::FLOAT32, 1),
+                    std::invalid_argument);
+
+    std::ostringstream ascii;
+    file.write(ascii, false);
+    const auto text = ascii.str();
+    CHECK(text.find("property float x\n") != text.npos);
+    CHECK(text.find("property uchar red\n") != text.npos);
+    CHECK(text.find("property list uchar ushort vertex_indices\n") != text.npos);
+    CHECK(text.ends_with("0.1 -2.5 inf 0 128 255 \n"
+                         "3 4 5 255 0 64 \n"
+                         "3 1 65535 0 \n"));
+
+    std::ostringstream binary;
+    file.write(binary, true);
+    const auto s = binary.str();
+    const auto payload = s.substr(s.find("end_header\n") + 11);
+    REQUIRE(payload.size() == 2 * (3 * 4 + 3) + 1 + 3 * 2);
+
+    float x;
+    std::memcpy(&x, payload.data(), 4);
+    CHECK(x == 0.1f);
+    CHECK(uint8_t(payload[13]) == 128);
+    uint16_t index;
+    std::memcpy(&index, payload.data() + 33, 2);
+    CHECK(index == 65535);
+
+    // Scaling alone, without a change of type.
+    impl::FileOut scaled;
+    scaled.add_properties_to_element("vertex", {"red", "green", "blue"},
+                                     Type::FLOAT32, 2, bytes(rgb),
+                                     Type::INVALID, 0);
+    scaled.set_output_type("vertex", {"red", "green", "blue"}, Type::FLOAT32, 2);
+    std::ostringstream doubled;
+    scaled.write(doubled, false);
+    CHECK(doubled.str().ends_with("0 1 2.4 \n2 -0.2 0.5 \n"));
+}
+
+TEST_CASE("big-endian output swaps every value and list count")
+{
+    const std::vector<float> xy {1.f, -2.f,  3.5f, 4.25f,  0.f, 1e-3f};
+    const std::vector<uint16_t> tags {1, 258, 65535};
+    const std::vector<int32_t> indices {0, 1, 2,  2, 1, 0, 3};
+    const std::vector<size_t> offsets {0, 3, 7};
+
+    auto bytes = [](const auto& v) {
+        return reinterpret_cast<uint8_t const*>(v.data());
+    };
+
+    impl::FileOut file;
+    file.add_properties_to_element("vertex", {"x", "y"}, Type::FLOAT32, 3,
+                                   bytes(xy), Type::INVALID, 0);
+    file.add_properties_to_element("vertex", {"tag"}, Type::UINT16, 3,
+                                   bytes(tags), Type::INVALID, 0);
+    file.add_list_property_to_element("face", "vertex_indices", Type::INT32, 2,
+                                      bytes(indices), Type::UINT16,
+                                      offsets.data());
+
+    auto payload = [&file] {
+        std::ostringstream os;
+        file.write(os, true);
+        const auto s = os.str();
+        return s.substr(s.find("end_header\n") + 11);
+    };
+
+    const auto little = payload();
+    file.bigEndian = true;
+    const auto big = payload();
+
+    // Widths of the values in the order of the file.
+    std::vector<size_t> widths;
+    for (size_t i {}; i < 3; ++i)
+        widths.insert(widths.end(), {4, 4, 2});
+    for (size_t i {}; i < 2; ++i) {
+        widths.push_back(2);
+        widths.insert(widths.end(), offsets[i+1] - offsets[i], 4);
+    }
+
+    auto swapped = little;
+    size_t at {};
+    for (const auto w: widths) {
+        std::reverse(swapped.begin() + at, swapped.begin() + at + w);
+        at += w;
+    }
+    REQUIRE(at == little.size());
+    CHECK(big == swapped);
+
+    std::ostringstream os;
+    file.write(os, true);
+    CHECK(os.str().find("format binary_big_endian 1.0\n") != std::string::npos);
+
+    // Records from a single contiguous array are swapped as well.
+    impl::FileOut contiguous;
+    contiguous.bigEndian = true;
+    contiguous.add_properties_to_element("vertex", {"tag"}, Type::UINT16, 3,
+                                         bytes(tags), Type::INVALID, 0);
+    std::ostringstream c;
+    contiguous.write(c, true);
+    CHECK(c.str().ends_with(std::string("\x00\x01\x01\x02\xff\xff", 6)));
+}
+
+TEST_CASE("list counts are read through their own type")
+{
+    // A long list counted by int, followed by a short one counted by uchar.
+    const std::vector<int32_t> longs(300, 7);
+    const std::vector<int32_t> shorts {5};
+
+    for (const int format: {0, 1, 2}) {
+
+        impl::FileOut file;
+        file.bigEndian = format == 2;
+        file.add_properties_to_element(
+            "face", {"a"}, Type::INT32, 1,
+            reinterpret_cast<uint8_t const*>(longs.data()), Type::INT32, longs.size()
+        );
+        file.add_properties_to_element(
+            "face", {"b"}, Type::INT32, 1,
+            reinterpret_cast<uint8_t const*>(shorts.data()), Type::UINT8, shorts.size()
+        );
+        std::stringstream ss;
+        file.write(ss, format != 0);
+
+        impl::FileIn in;
+        REQUIRE(in.header.parse(ss));
+        const auto b = in.request_properties_from_element("face", {"b"});
+        in.read(ss);
+        REQUIRE(b->as_span<int32_t>().size() == 1);
+        CHECK(b->as_span<int32_t>()[0] == 5);
+    }
+}
+
+TEST_CASE("write-behind and asynchronous writes produce the same output")
+{
+    const size_t n = 1'000'000;  // several chunks
+    std::vector<float> xyz(3 * n);
+    for (size_t i {}; i < xyz.size(); ++i)
+        xyz[i] = 0.5f * i;
+    std::vector<uint8_t> labels(n, 3);
+
+    auto bytes = [](const auto& v) {
+        return reinterpret_cast<uint8_t const*>(v.data());
+    };
+
+    Writer writer;
+    writer.add_properties_to_element("vertex", {"x", "y", "z"}, Type::FLOAT32,
+                                     n, bytes(xyz), Type::INVALID, 0);
+    writer.add_properties_to_element("vertex", {"label"}, Type::UINT8,
+                                     n, bytes(labels), Type::INVALID, 0);
+
+    auto& file = *writer.file;
+    for (const bool asBinary: {true, false}) {
+
+        std::ostringstream expected;
+        file.queuedChunks = 0;
+        file.write(expected, asBinary);
+
+        std::ostringstream behind;
+        file.queuedChunks = 2;
+        file.write(behind, asBinary);
+        CHECK(behind.str() == expected.str());
+
+        const auto path = std::filesystem::temp_directory_path() / "tinyply-async.ply";
+        auto done = writer.write_async(path, asBinary);
+        done.get();
+
+        std::ifstream is(path, std::ios::binary);
+        const std::string written {std::istreambuf_iterator<char>(is), {}};
+        CHECK(written == expected.str());
+        std::filesystem::remove(path);
+    }
+
+    // Write errors surface alike with and without the background thread.
+    for (const size_t queuedChunks: {0, 2})
+        for (const bool asBinary: {true, false}) {
+            std::ostringstream broken;
+            broken.setstate(std::ios::badbit);
+            file.queuedChunks = queuedChunks;
+            CHECK_THROWS_AS(file.write(broken, asBinary), std::runtime_error);
+        }
+}
+
+TEST_CASE("records of mixed types are written from a field descriptor")
+{
+    struct Vertex {
+        float x, y, z;
+        uint8_t red, green, blue;
+        double time;
+    };
+
+    const std::vector<Vertex> vertices {
+        {1.f, 2.f, 3.f, 10, 20, 30, 0.125},
+        {-1.f, 0.5f, 0.f, 255, 0, 1, 1e10},
+    };
+
+    for (const bool asBinary: {true, false}) {
+
+        impl::FileOut file;
+        file.add_record_to_element(
+            "vertex", vertices.size(),
+            reinterpret_cast<uint8_t const*>(vertices.data()), sizeof(Vertex),
+            {{"x", Type::FLOAT32, offsetof(Vertex, x)},
+             {"y", Type::FLOAT32, offsetof(Vertex, y)},
+             {"z", Type::FLOAT32, offsetof(Vertex, z)},
+             {"red", Type::UINT8, offsetof(Vertex, red)},
+             {"green", Type::UINT8, offsetof(Vertex, green)},
+             {"blue", Type::UINT8, offsetof(Vertex, blue)},
+             {"time", Type::FLOAT64, offsetof(Vertex, time)}}
+        );
+        std::ostringstream os;
+        file.write(os, asBinary);
+        const auto s = os.str();
+
+        CHECK(s.find("property uchar red\nproperty uchar green\n"
+                     "property uchar blue\nproperty double time\n") != s.npos);
+
+        if (!asBinary) {
+            CHECK(s.ends_with("1 2 3 10 20 30 0.125 \n"
+                              "-1 0.5 0 255 0 1 1e+10 \n"));
+            continue;
+        }
+
+        const auto payload = s.substr(s.find("end_header\n") + 11);
+        REQUIRE(payload.size() == 2 * (3 * 4 + 3 + 8));
+        double time;
+        std::memcpy(&time, payload.data() + 23 + 15, 8);
+        CHECK(time == 1e10);
+        CHECK(uint8_t(payload[23 + 12]) == 255);
+    }
+
+    impl::FileOut file;
+    CHECK_THROWS_AS(file.add_record_to_element(
+                        "vertex", 1, nullptr, 4,
+                        {{"time", Type::FLOAT64, 0}}),
+                    std::invalid_argument);
+}
+
+TEST_CASE("properties of mixed types are read into user records")
+{
+    struct Point {
+        float x, y, z;
+        uint16_t intensity;
+        uint8_t returns;
+        double time;
+    };
+    std::vector<Point> points(100);
+    for (size_t i {}; i < points.size(); ++i)
+        points[i] = {0.5f * i, -1.f * i, 2.f, uint16_t(i * 600), uint8_t(i % 4), 1e9 + i};
+
+    const std::vector<Field> fields {
+        {"x", Type::FLOAT32, offsetof(Point, x)},
+        {"y", Type::FLOAT32, offsetof(Point, y)},
+        {"z", Type::FLOAT32, offsetof(Point, z)},
+        {"intensity", Type::UINT16, offsetof(Point, intensity)},
+        {"returns", Type::UINT8, offsetof(Point, returns)},
+        {"gps_time", Type::FLOAT64, offsetof(Point, time)},
+    };
+
+    // Laid out differently in memory than in the file.
+    struct Sample {
+        double time;
+        uint8_t returns;
+        float position[3];
+        uint16_t intensity;
+    };
+    const std::vector<Field> sampleFields {
+        {"gps_time", Type::FLOAT64, offsetof(Sample, time)},
+        {"returns", Type::INVALID, offsetof(Sample, returns)},
+        {"x", Type::FLOAT32, offsetof(Sample, position)},
+        {"y", Type::FLOAT32, offsetof(Sample, position) + 4},
+        {"z", Type::FLOAT32, offsetof(Sample, position) + 8},
+        {"intensity", Type::UINT16, offsetof(Sample, intensity)},
+    };
+
+    for (const int format: {0, 1, 2}) {  // ascii, little and big endian
+
+        impl::FileOut out;
+        out.add_record_to_element("vertex", points.size(),
+                                  reinterpret_cast<uint8_t const*>(points.data()),
+                                  sizeof(Point), fields);
+        out.add_properties_to_element("tail", {"t"}, Type::INT32, 1,
+                                      reinterpret_cast<uint8_t const*>(&format),
+                                      Type::INVALID, 0);
+        out.bigEndian = format == 2;
+        std::ostringstream os;
+        out.write(os, format != 0);
+
+        std::istringstream is(os.str());
+        Reader reader;
+        REQUIRE(reader.parse_header(is));
+        const auto data = reader.request_record_from_element("vertex", sampleFields,
+                                                             sizeof(Sample));
+        CHECK(reader.plan().groups[0].bytes == points.size() * sizeof(Sample));
+        reader.read(is);
+
+        REQUIRE(data->count == points.size());
+        REQUIRE(data->num_items() == points.size());
+        const auto* samples = reinterpret_cast<const Sample*>(data->buffer.get());
+        for (size_t i {}; i < points.size(); ++i) {
+            CHECK(samples[i].time == points[i].time);
+            CHECK(samples[i].returns == points[i].returns);
+            CHECK(samples[i].position[0] == points[i].x);
+            CHECK(samples[i].position[1] == points[i].y);
+            CHECK(samples[i].position[2] == points[i].z);
+            CHECK(samples[i].intensity == points[i].intensity);
+        }
+    }
+
+    std::istringstream is("ply\nformat ascii 1.0\nelement vertex 1\n"
+                          "property float x\nend_header\n1\n");
+    Reader reader;
+    REQUIRE(reader.parse_header(is));
+    CHECK_THROWS_AS(reader.request_record_from_element(
+                        "vertex", {{"x", Type::FLOAT64, 0}}, 8),
+                    std::invalid_argument);
+    CHECK_THROWS_AS(reader.request_record_from_element(
+                        "vertex", {{"x", Type::FLOAT32, 2}}, 4),
+                    std::invalid_argument);
+
+    // A list longer than its field stops the read before overwriting the
+    // fields after it.
+    struct Face {
+        uint32_t indices[3];
+        int32_t tag;  // read before the indices
+    };
+    const std::vector<Field> faceFields {
+        {"tag", Type::INT32, offsetof(Face, tag)},
+        {"vertex_indices", Type::UINT32, offsetof(Face, indices), Type::UINT8, 3},
+    };
+    std::istringstream faces("ply\nformat ascii 1.0\nelement face 2\n"
+                             "property int tag\nproperty list uchar uint vertex_indices\n"
+                             "end_header\n1 3 0 1 2\n2 4 0 1 2 3\n");
+    Reader faceReader;
+    REQUIRE(faceReader.parse_header(faces));
+    const auto faceData = faceReader.request_record_from_element("face", faceFields,
+                                                                 sizeof(Face));
+    CHECK_THROWS_AS(faceReader.read(faces), std::runtime_error);
+    CHECK(faceData->as_span<Face>()[1].tag == 2);
+}
+
+TEST_CASE("typed views check the type of the data")
+{
+    std::istringstream is(
+        "ply\nformat ascii 1.0\nelement vertex 2\nproperty float x\nproperty float y\n"
+        "element face 2\nproperty list uchar int vertex_indices\nend_header\n"
+        "1 2\n3 4\n3 0 1 2\n3 2 1 0\n");
+
+    Reader file;
+    REQUIRE(file.parse_header(is));
+    const auto xy = file.request_properties_from_element("vertex", {"x", "y"});
+    const auto faces = file.request_properties_from_element("face", {"vertex_indices"}, 3);
+    file.read(is);
+
+    const auto& points = *xy;
+    CHECK(points.as_span<float>().size() == 4);
+    CHECK_THROWS_AS(points.as_span<double>(), std::invalid_argument);
+    CHECK_THROWS_AS(points.as_span<int32_t>(), std::invalid_argument);
+
+    const auto rows = points.as_rows<float>();
+    REQUIRE(rows.size() == 2);
+    CHECK(rows.components() == 2);
+    CHECK(rows[1][0] == 3.f);
+
+    std::vector<int32_t> indices;
+    for (const auto face : faces->as_rows<int32_t>()) {
+        CHECK(face.size() == 3);
+        indices.push_back(face[2]);
+    }
+    CHECK(indices == std::vector<int32_t> {2, 0});
+
+    faces->as_span<int32_t>()[0] = 7;
+    CHECK(faces->as_rows<int32_t>()[0][0] == 7);
+
+    // Read-only views of const data.
+    const Data& constant = *faces;
+    CHECK(constant.as_span<const int32_t>()[0] == 7);
+    CHECK(constant.as_rows<const int32_t>()[1][0] == 2);
+    CHECK(std::ranges::equal(constant.as_span<int32_t>(),
+                             std::vector<int32_t> {7, 1, 2, 2, 1, 0}));
+}
+
+TEST_CASE("writer serializes into memory")
+{
+    const std::vector<float> xyz {0, 1, 2, 3, 4, 5};
+    const std::vector<size_t> offsets {0, 3, 6};
+    const std::vector<uint32_t> indices {0, 1, 2, 3, 2, 1};
+
+    Writer writer;
+    writer.add_comment("in memory");
+    writer.add_properties_to_element(
+        "vertex", {"x", "y", "z"}, Type::FLOAT32, 2,
+        reinterpret_cast<uint8_t const*>(xyz.data()), Type::INVALID, 0
+    );
+    writer.add_list_property_to_element(
+        "face", "vertex_indices", Type::UINT32, 2,
+        reinterpret_cast<uint8_t const*>(indices.data()), Type::UINT8,
+        offsets.data()
+    );
+
+    for (const bool asBinary: {false, true}) {
+        std::ostringstream os;
+        writer.file->write(os, asBinary);
+        const auto expected = os.str();
+
+        const auto bytes = writer.write_to_memory(asBinary);
+        CHECK(std::string(bytes.begin(), bytes.end()) == expected);
+    }
+
+    const size_t size = writer.binary_size();
+    std::vector<std::byte> payload(size + 4);
+    CHECK(writer.write_binary(payload) == size);
+    CHECK_THROWS_AS(writer.write_binary(std::span {payload}.first(size - 1)),
+                    std::length_error);
+
+    std::istringstream is(std::string(reinterpret_cast<const char*>(payload.data()), size));
+    Reader reader;
+    REQUIRE(reader.parse_header(is));
+    const auto x = reader.request_properties_from_element("vertex", {"x", "y", "z"});
+    const auto f = reader.request_properties_from_element("face", {"vertex_indices"}, 3);
+    reader.read(is);
+    CHECK(std::ranges::equal(x->as_span<float>(), xyz));
+    CHECK(std::ranges::equal(f->as_span<uint32_t>(), indices));
+}
+
+namespace {
+
+    // Hands out a few bytes at a time and cannot go back, as a decompressor.
+    struct TrickleSource
+        : ByteSource {
+
+        std::string text;
+        size_t at {};
+
+        explicit TrickleSource(std::string text)
+            : text {std::move(text)}
+        {}
+
+        std::span<const uint8_t> pull() override
+        {
+            const size_t n = std::min<size_t>(3, text.size() - at);
+            at += n;
+            return {reinterpret_cast<const uint8_t*>(text.data()) + at - n, n};
+        }
+    };
+
+}  // namespace
+
+TEST_CASE("byte sources feed the parser")
+{
+    const std::vector<float> xyz {0.5f, -1, 2e-7f, 3, 4.25f, -5e10f};
+    const std::vector<uint32_t> indices {0, 1, 2, 2, 1, 0};
+
+    for (const bool asBinary: {false, true}) {
+
+        impl::FileOut file;
+        file.header.comments.push_back("byte sources");
+        file.add_properties_to_element(
+            "vertex", {"x", "y", "z"}, Type::FLOAT32, 2,
+            reinterpret_cast<uint8_t const*>(xyz.data()), Type::INVALID, 0
+        );
+        file.add_properties_to_element(
+            "face", {"vertex_indices"}, Type::UINT32, 2,
+            reinterpret_cast<uint8_t const*>(indices.data()), Type::UINT8, 3
+        );
+        std::ostringstream os;
+        file.write(os, asBinary);
+        const auto text = os.str();
+
+        auto check = [&](Reader& reader, auto&& read, const uint32_t hint) {
+            const auto v = reader.request_properties_from_element("vertex", {"x", "y", "z"});
+            const auto f = reader.request_properties_from_element("face", {"vertex_indices"}, hint);
+            read();
+            CHECK(std::ranges::equal(v->as_span<float>(), xyz));
+            CHECK(std::ranges::equal(f->as_span<uint32_t>(), indices));
+        };
+
+        {
+            MemorySource source {std::span {reinterpret_cast<const uint8_t*>(text.data()),
+                                            text.size()}};
+            Reader reader;
+            REQUIRE(reader.parse_header(source));
+            CHECK(reader.get_info().empty());
+            check(reader, [&] { reader.read(source); }, 0);
+        }
+        {
+            // Tokens, lines and values split between buffers;
+            // lists without a size hint seek back for the second pass.
+            std::istringstream is(text + "trailing");
+            StreamSource source {is, 5};
+            Reader reader;
+            REQUIRE(reader.parse_header(source));
+            CHECK(reader.comments() == std::vector<std::string> {"byte sources"});
+            check(reader, [&] { reader.read(source); }, 0);
+        }
+        {
+            std::istringstream is(text + "trailing");
+            Reader reader;
+            REQUIRE(reader.parse_header(is));
+            check(reader, [&] { reader.read(is); }, 0);
+            std::string rest;
+            is >> rest;
+            CHECK(rest == "trailing");
+        }
+        {
+            TrickleSource source {text};
+            Reader reader;
+            REQUIRE(reader.parse_header(source));
+            check(reader, [&] { reader.read(source); }, 3);
+        }
+        {
+            TrickleSource source {text};
+            Reader reader;
+            REQUIRE(reader.parse_header(source));
+            reader.request_properties_from_element("face", {"vertex_indices"});
+            CHECK_THROWS_AS(reader.read(source), std::runtime_error);
+        }
+        {
+            // Sources made one after another, likely at the same address,
+            // are each read from their own start.
+            const std::span bytes {reinterpret_cast<const uint8_t*>(text.data()),
+                                   text.size()};
+            impl::FileIn file;
+            REQUIRE(file.header.parse(text));
+            const auto v = file.request_properties_from_element("vertex", {"x", "y", "z"});
+            for (int i {}; i < 3; ++i) {
+                MemorySource payload {bytes.subspan(file.header.headerBytes)};
+                std::ranges::fill(v->as_span<float>(), 0.f);
+                file.read(payload);
+                CHECK(std::ranges::equal(v->as_span<float>(), xyz));
+            }
+
+            Reader reader;
+            REQUIRE(reader.parse_header(std::string_view {text}));
+            MemorySource payload {bytes.subspan(reader.header_size())};
+            check(reader, [&] { reader.read(payload); }, 3);
+
+            MemorySource first {bytes};
+            MemorySource second {bytes};
+            Reader other;
+            REQUIRE(other.parse_header(first));
+            CHECK_THROWS_AS(other.read(second), std::invalid_argument);
+        }
+    }
+}
+
+TEST_CASE("transcoding keeps the whole file")
+{
+    const std::vector<float> xyz {0.5f, -1, 2e-7f, 3, 4.25f, -5e10f};
+    const std::vector<uint8_t> tags {7, 255};
+    const std::vector<size_t> offsets {0, 3, 7};
+    const std::vector<int32_t> indices {0, 1, 2, 3, 2, 1, -1};
+
+    impl::FileOut file;
+    file.header.comments.push_back("transcoded");
+    file.header.objInfo.push_back("num_cols 2");
+    file.add_properties_to_element(
+        "vertex", {"x", "y", "z"}, Type::FLOAT32, 2,
+        reinterpret_cast<uint8_t const*>(xyz.data()), Type::INVALID, 0
+    );
+    file.add_properties_to_element(
+        "vertex", {"tag"}, Type::UINT8, 2,
+        reinterpret_cast<uint8_t const*>(tags.data()), Type::INVALID, 0
+    );
+    file.add_list_property_to_element(
+        "face", "vertex_indices", Type::INT32, 2,
+        reinterpret_cast<uint8_t const*>(indices.data()), Type::UINT16,
+        offsets.data()
+    );
+
+    std::ostringstream ascii;
+    file.write(ascii, false);
+    std::ostringstream little;
+    file.write(little, true);
+    file.bigEndian = true;
+    std::ostringstream big;
+    file.write(big, true);
+
+    const std::vector<std::pair<std::string, Encoding>> encodings {
+        {ascii.str(), Encoding::ASCII},
+        {little.str(), Encoding::BINARY_LITTLE_ENDIAN},
+        {big.str(), Encoding::BINARY_BIG_ENDIAN},
+    };
+
+    // Every encoding transcodes to what the writer writes.
+    for (const auto& [from, _]: encodings)
+        for (const auto& [to, encoding]: encodings) {
+            std::istringstream is(from);
+            StreamSource small {is, 4};
+            std::ostringstream os;
+            transcode(small, os, encoding);
+            CHECK(os.str() == to);
+        }
+
+    std::istringstream truncated(little.str().substr(0, little.str().size() - 2));
+    StreamSource source {truncated};
+    std::ostringstream os;
+    CHECK_THROWS_AS(transcode(source, os, Encoding::ASCII), std::runtime_error);
+
+    // Neither an empty input nor one without the magic is a ply file.
+    for (const std::string text: {"", "format ascii 1.0\nend_header\n"}) {
+        std::istringstream is(text);
+        StreamSource notPly {is};
+        std::ostringstream out;
+        CHECK_THROWS_AS(transcode(notPly, out, Encoding::ASCII),
+                        std::runtime_error);
+    }
+
+    // A file transcodes in place.
+    const auto p = std::filesystem::temp_directory_path() / "tinyply-transcode.ply";
+    std::ofstream(p, std::ios::binary) << ascii.str();
+    transcode(p, p, Encoding::BINARY_BIG_ENDIAN);
+    std::ifstream in(p, std::ios::binary);
+    CHECK(std::string(std::istreambuf_iterator<char>(in), {}) == big.str());
+    in.close();
+    std::filesystem::remove(p);
+}
+
+TEST_CASE("rewriting copies the unchanged elements")
+{
+    const auto dir = std::filesystem::temp_directory_path() / "tinyply-rewrite";
+    std::filesystem::create_directories(dir);
+
+    const std::vector<float> xyz {0, 1, 2, 3, 4, 5};
+    const std::vector<uint8_t> colors {10, 20, 30, 40, 50, 60};
+    const std::vector<uint8_t> recolored {1, 2, 3, 4, 5, 6};
+    const std::vector<size_t> offsets {0, 3, 7};
+    const std::vector<int32_t> indices {0, 1, 2, 3, 2, 1, 0};
+    const std::vector<int16_t> edges {0, 1, 1, 0};
+
+    auto add = [&](impl::FileOut& file, const std::vector<uint8_t>& rgb) {
+        file.add_properties_to_element(
+            "vertex", {"x", "y", "z"}, Type::FLOAT32, 2,
+            reinterpret_cast<uint8_t const*>(xyz.data()), Type::INVALID, 0
+        );
+        file.add_properties_to_element(
+            "vertex", {"red", "green", "blue"}, Type::UINT8, 2,
+            reinterpret_cast<uint8_t const*>(rgb.data()), Type::INVALID, 0
+        );
+    };
+    auto add_rest = [&](impl::FileOut& file) {
+        file.add_list_property_to_element(
+            "face", "vertex_indices", Type::INT32, 2,
+            reinterpret_cast<uint8_t const*>(indices.data()), Type::UINT8,
+            offsets.data()
+        );
+        file.add_properties_to_element(
+            "edge", {"v0", "v1"}, Type::INT16, 2,
+            reinterpret_cast<uint8_t const*>(edges.data()), Type::INVALID, 0
+        );
+    };
+    auto contents = [](const std::filesystem::path& p) {
+        std::ifstream is(p, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(is), {});
+    };
+
+    for (const bool bigEndian: {false, true}) {
+
+        const auto from = dir / "from.ply";
+        const auto to = dir / "to.ply";
+        const auto expected = dir / "expected.ply";
+        {
+            impl::FileOut file;
+            file.header.comments.push_back("source");
+            file.bigEndian = bigEndian;
+            add(file, colors);
+            add_rest(file);
+            file.write(from, true);
+        }
+        {
+            impl::FileOut file;
+            file.header.comments.push_back("source");
+            file.bigEndian = bigEndian;
+            add(file, recolored);
+            add_rest(file);
+            file.write(expected, true);
+        }
+
+        Writer writer;
+        add(*writer.file, recolored);
+        writer.rewrite(from, to);
+        CHECK(contents(to) == contents(expected));
+
+        // The byte order of the source does not stick to the writer.
+        CHECK(!writer.file->bigEndian);
+
+        // In place, the source is read in full before being replaced.
+        const auto inPlace = dir / "in-place.ply";
+        std::filesystem::copy_file(from, inPlace);
+        writer.rewrite(inPlace, inPlace);
+        CHECK(contents(inPlace) == contents(expected));
+        std::filesystem::remove(inPlace);
+
+        // Offsets of the elements, past the header.
+        MappedFile source {from};
+        impl::ByteReader in {source};
+        impl::FileIn file;
+        REQUIRE(file.header.parse(in));
+        const auto at = file.element_offsets(in);
+        REQUIRE(at.size() == 4);
+        CHECK(at[1] - at[0] == 2 * 15);
+        CHECK(at[2] - at[1] == 2 + 7 * 4);
+        CHECK(at[3] - at[2] == 2 * 4);
+        CHECK(at[3] == std::filesystem::file_size(from));
+    }
+
+    {
+        impl::FileOut file;
+        add(file, colors);
+        file.write(dir / "ascii.ply", false);
+    }
+    Writer writer;
+    add(*writer.file, recolored);
+    CHECK_THROWS_AS(writer.rewrite(dir / "ascii.ply", dir / "out.ply"),
+                    std::invalid_argument);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("plytool offsets merged faces and subsamples")
+{
+    const auto dir = std::filesystem::temp_directory_path() / "tinyply-plytool";
+    std::filesystem::create_directories(dir);
+
+    auto write = [&](const std::filesystem::path& p,
+                     const std::vector<float>& x,
+                     const std::vector<uint8_t>& indices) {
+        impl::FileOut file;
+        file.add_properties_to_element(
+            "vertex", {"x"}, Type::FLOAT32, x.size(),
+            reinterpret_cast<uint8_t const*>(x.data()), Type::INVALID, 0
+        );
+        file.add_properties_to_element(
+            "face", {"vertex_indices"}, Type::UINT8, indices.size() / 3,
+            indices.data(), Type::UINT8, 3
+        );
+        file.write(p, true);
+    };
+    write(dir / "a.ply", {0, 1, 2, 3, 4}, {0, 1, 2, 2, 3, 4});
+    write(dir / "b.ply", {5, 6, 7}, {2, 1, 0});
+
+    // Faces of the second file index the vertices appended after the first.
+    tools::merge({(dir / "merged.ply").string(),
+                  (dir / "a.ply").string(), (dir / "b.ply").string()});
+    const auto merged = tools::load(dir / "merged.ply");
+    REQUIRE(merged.header.elements.size() == 2);
+    CHECK(merged.header.elements[0].size == 8);
+    REQUIRE(merged.header.elements[1].size == 3);
+    const auto* faces = merged.columns[1][0]->buffer.get();
+    CHECK(std::vector<uint8_t>(faces, faces + 9) ==
+          std::vector<uint8_t> {0, 1, 2, 2, 3, 4, 7, 6, 5});
+
+    // Offset indices that no longer fit into their type throw.
+    write(dir / "c.ply", std::vector<float>(200), {0, 1, 199});
+    CHECK_THROWS_AS(tools::merge({(dir / "merged.ply").string(),
+                                  (dir / "c.ply").string(),
+                                  (dir / "c.ply").string()}),
+                    std::out_of_range);
+
+    // Every second vertex is kept; faces are renumbered, or dropped
+    // with a removed vertex.
+    write(dir / "d.ply", {0, 1, 2, 3, 4, 5}, {0, 2, 4, 0, 1, 2, 4, 2, 0});
+    tools::subsample({(dir / "d.ply").string(), (dir / "sub.ply").string(),
+                      "vertex", "2"});
+    const auto sub = tools::load(dir / "sub.ply");
+    REQUIRE(sub.header.elements[0].size == 3);
+    float x[3];
+    std::memcpy(x, sub.columns[0][0]->buffer.get(), sizeof(x));
+    CHECK(x[0] == 0);
+    CHECK(x[1] == 2);
+    CHECK(x[2] == 4);
+    REQUIRE(sub.header.elements[1].size == 2);
+    const auto* kept = sub.columns[1][0]->buffer.get();
+    CHECK(std::vector<uint8_t>(kept, kept + 6) ==
+          std::vector<uint8_t> {0, 1, 2, 2, 1, 0});
+
+    // Requested properties must all exist.
+    CHECK_THROWS_AS(tools::extract({(dir / "a.ply").string(),
+                                    (dir / "x.ply").string(), "vertex:x,xx"}),
+                    std::invalid_argument);
+
+    std::filesystem::remove_all(dir);
+}
+
 //TEST_CASE("check that int128 is an unrecognized, non-conformant datatype")
 //{
 //    std::ifstream filestream("../assets/validate/invalid/header.invalid-face-data-type-int128.ply", std::ios::binary);
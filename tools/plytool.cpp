@@ -0,0 +1,67 @@
+
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Command-line access to the library for triage and benchmarking;
+// see plytool.h for the commands.
+
+#include "plytool.h"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//  ////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    namespace tools = tinyply::tools;
+
+    const std::map<std::string_view, int (*)(const std::vector<std::string>&)> commands {
+        {"info", tools::info},
+        {"convert", tools::convert},
+        {"extract", tools::extract},
+        {"subsample", tools::subsample},
+        {"merge", tools::merge},
+        {"bench", tools::bench},
+    };
+
+    const auto command = argc > 1 ? commands.find(argv[1]) : commands.end();
+    if (command == commands.end()) {
+        std::cerr << "usage: " << argv[0]
+                  << " info|convert|extract|subsample|merge|bench <args>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        return command->second({argv + 2, argv + argc});
+    }
+    catch (const std::exception& e) {
+        std::cerr << "plytool " << argv[1] << ": " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
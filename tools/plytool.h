@@ -0,0 +1,520 @@
+/*
+ * This file is derived from
+ * tinyply 2.3.4 (https://github.com/ddiakopoulos/tinyply)
+ *
+ * A zero-dependency (except the C++ STL) public domain implementation
+ * of the PLY file format. Requires C++20; errors are handled through exceptions.
+ *
+ * This software is in the public domain. Where that dedication is not
+ * recognized, you are granted a perpetual, irrevocable license to copy,
+ * distribute, and modify this file as you see fit.
+ *
+ * Authored by Dimitri Diakopoulos (http://www.dimitridiakopoulos.com)
+ * Modified by Valerii Sukhorukov (vsukhorukov@yahoo.com, https://github.com/vsukhor)
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHORS DISCLAIM ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Command-line access to the library for triage and benchmarking:
+//
+//     plytool info <file.ply>
+//     plytool convert <in.ply> <out.ply> ascii|binary|binary_big_endian
+//     plytool extract <in.ply> <out.ply> <element>[:<property>,...] ...
+//     plytool subsample <in.ply> <out.ply> <element> <every>
+//     plytool merge <out.ply> <in.ply> <in.ply> ...
+//     plytool bench <file.ply> [repeats]
+//
+// `extract`, `subsample` and `merge` keep the encoding of their (first)
+// input, writing binary output little-endian. `subsample` of the vertices
+// renumbers the vertex indices of the faces, dropping the faces of removed
+// vertices. The commands are declared
+// here, apart from `main`, so that the tests can run them.
+
+#ifndef TINYPLY_TOOLS_PLYTOOL_H
+#define TINYPLY_TOOLS_PLYTOOL_H
+
+#include "tinyply.h"
+
+#include <algorithm>
+#include <charconv>  // from_chars
+#include <chrono>
+#include <cstdint>  // uint8_t, int8_t, uint16_t, int16_t, etc
+#include <cstdlib>
+#include <cstring>  // memcpy
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>  // function
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>  // cmp_less, cmp_greater
+#include <vector>
+
+namespace tinyply::tools {
+
+namespace fs = std::filesystem;
+using impl::Data;
+using impl::Element;
+using impl::Property;
+
+/**
+ * Properties of a file read whole, one Data per property.
+ */
+struct Table {
+
+    impl::Header header;
+    std::vector<std::vector<std::shared_ptr<Data>>> columns;  ///< [element][property]
+};
+
+// Bytes of a record of `p`, lists being of fixed length once read.
+inline size_t value_bytes(const Property& p)
+{
+    return impl::types.at(p.scalarType).stride * (p.is_list() ? p.listCount : 1);
+}
+
+/**
+ * Reads the properties selected per element, all of those of an element
+ * selected without names, or everything if `selection` is empty.
+ */
+inline Table load(const fs::path& path,
+                  const std::map<std::string, std::vector<std::string>>& selection = {})
+{
+    MappedFile source {path};
+    impl::ByteReader in {source};
+
+    impl::FileIn file;
+    if (!file.header.parse(in))
+        throw std::runtime_error("malformed header in " + path.string());
+
+    Table table;
+    for (const auto& e: file.header.elements) {
+
+        const auto s = selection.find(e.name);
+        if (!selection.empty() && s == selection.end())
+            continue;
+        if (s != selection.end())
+            for (const auto& name: s->second)
+                if (!e.get_property(name))
+                    throw std::invalid_argument("no property " + name + " in element " +
+                                                e.name + " of " + path.string());
+
+        auto& columns = table.columns.emplace_back();
+        Element kept {e.name, e.size};
+        for (const auto& p: e.properties)
+            if (selection.empty() || s->second.empty() ||
+                std::ranges::find(s->second, p.name) != s->second.end()) {
+                columns.push_back(file.request_properties_from_element(e, {p.name}, 0));
+                kept.properties.push_back(p);
+            }
+        if (columns.empty())
+            throw std::invalid_argument("no selected property in element " + e.name);
+        table.header.elements.push_back(kept);
+    }
+    for (const auto& [name, _]: selection)
+        if (!file.header.find_element(name))
+            throw std::invalid_argument("no element " + name + " in " + path.string());
+
+    file.read(in);
+
+    // The counting pass has found the list lengths.
+    for (auto& e: table.header.elements)
+        for (auto& p: e.properties)
+            p.listCount = file.header.find_element(e.name)->get_property(p.name)->listCount;
+
+    table.header.isBinary = file.header.isBinary;
+    table.header.comments = file.header.comments;
+    table.header.objInfo = file.header.objInfo;
+
+    return table;
+}
+
+inline void save(const Table& table,
+                 const fs::path& path,
+                 const bool asBinary)
+{
+    impl::FileOut file;
+    file.header.comments = table.header.comments;
+    file.header.objInfo = table.header.objInfo;
+
+    for (size_t i {}; i < table.header.elements.size(); ++i) {
+
+        const auto& e = table.header.elements[i];
+        for (size_t k {}; k < e.properties.size(); ++k) {
+            const auto& p = e.properties[k];
+            file.add_properties_to_element(e.name, {p.name}, p.scalarType, e.size,
+                                           table.columns[i][k]->buffer.get(),
+                                           p.listType, p.listCount);
+        }
+    }
+
+    file.write(path, asBinary);
+}
+
+// Whether `p` of `e` holds indices into the vertex element.
+inline bool is_vertex_index(const Element& e,
+                            const Property& p)
+{
+    return e.name == "face" && (p.name == "vertex_indices" || p.name == "vertex_index");
+}
+
+// Replaces each of the `n` integer values at `p` of type `t` by `f` of it.
+template<typename F>
+void map_indices(uint8_t* p,
+                 const Type t,
+                 const size_t n,
+                 F&& f)
+{
+    auto map = [&]<typename T>(T) {
+        for (size_t i {}; i < n; ++i, p += sizeof(T)) {
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            const int64_t index = f(int64_t {v});
+            if (std::cmp_less(index, std::numeric_limits<T>::min()) ||
+                std::cmp_greater(index, std::numeric_limits<T>::max()))
+                throw std::out_of_range("vertex index " + std::to_string(index) +
+                                        " does not fit into " +
+                                        std::string(impl::types.at(t).str));
+            v = static_cast<T>(index);
+            std::memcpy(p, &v, sizeof(T));
+        }
+    };
+    switch (t) {
+        case Type::INT8:   return map(int8_t {});
+        case Type::UINT8:  return map(uint8_t {});
+        case Type::INT16:  return map(int16_t {});
+        case Type::UINT16: return map(uint16_t {});
+        case Type::INT32:  return map(int32_t {});
+        case Type::UINT32: return map(uint32_t {});
+        default: throw std::invalid_argument("vertex indices must be integers");
+    }
+}
+
+// Keeps the records `i` of `e` for which `keep[i]`, in place.
+inline void keep_records(Element& e,
+                         const std::vector<std::shared_ptr<Data>>& columns,
+                         const std::vector<bool>& keep)
+{
+    size_t kept {};
+    for (size_t k {}; k < columns.size(); ++k) {
+
+        const size_t bytes = value_bytes(e.properties[k]);
+        uint8_t* values = columns[k]->buffer.get();
+        kept = 0;
+        for (size_t i {}; i < e.size; ++i)
+            if (keep[i])
+                std::memmove(values + kept++ * bytes, values + i * bytes, bytes);
+    }
+    e.size = kept;
+}
+
+// Commands ====================================================================
+
+inline int info(const std::vector<std::string>& args)
+{
+    if (args.size() != 1)
+        throw std::invalid_argument("usage: plytool info <file.ply>");
+
+    MappedFile source {args[0]};
+    impl::ByteReader in {source};
+    impl::FileIn file;
+    if (!file.header.parse(in))
+        throw std::runtime_error("malformed header in " + args[0]);
+
+    const auto& h = file.header;
+    std::cout << args[0] << ": " << source.bytes().size() << " bytes, "
+              << (!h.isBinary ? "ascii" : h.isBigEndian ? "binary_big_endian"
+                                                       : "binary_little_endian")
+              << ", header of " << h.headerBytes << " bytes\n";
+    for (const auto& c: h.comments)
+        std::cout << "  comment " << c << "\n";
+    for (const auto& c: h.objInfo)
+        std::cout << "  obj_info " << c << "\n";
+
+    std::vector<uint64_t> offsets;
+    if (h.isBinary)
+        offsets = file.element_offsets(in);
+
+    for (size_t i {}; i < h.elements.size(); ++i) {
+
+        const auto& e = h.elements[i];
+        std::cout << "  element " << e.name << " " << e.size;
+        if (!offsets.empty())
+            std::cout << " (" << offsets[i + 1] - offsets[i]
+                      << " bytes at " << offsets[i] << ")";
+        std::cout << "\n";
+
+        for (const auto& p: e.properties) {
+            std::cout << "    property ";
+            if (p.is_list())
+                std::cout << "list " << impl::types.at(p.listType).str << " ";
+            std::cout << impl::types.at(p.scalarType).str << " " << p.name << "\n";
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+inline int convert(const std::vector<std::string>& args)
+{
+    if (args.size() != 3)
+        throw std::invalid_argument(
+            "usage: plytool convert <in.ply> <out.ply> ascii|binary|binary_big_endian"
+        );
+
+    transcode(args[0], args[1], encoding_from_name(args[2]));
+
+    return EXIT_SUCCESS;
+}
+
+inline int extract(const std::vector<std::string>& args)
+{
+    if (args.size() < 3)
+        throw std::invalid_argument(
+            "usage: plytool extract <in.ply> <out.ply> <element>[:<property>,...] ..."
+        );
+
+    std::map<std::string, std::vector<std::string>> selection;
+    for (size_t i = 2; i < args.size(); ++i) {
+
+        std::string_view s {args[i]};
+        const auto colon = s.find(':');
+        auto& properties = selection[std::string(s.substr(0, colon))];
+        if (colon == std::string_view::npos)
+            continue;
+
+        for (s.remove_prefix(colon + 1); !s.empty(); ) {
+            const auto comma = s.find(',');
+            properties.emplace_back(s.substr(0, comma));
+            s.remove_prefix(comma == std::string_view::npos ? s.size() : comma + 1);
+        }
+    }
+
+    const auto table = load(args[0], selection);
+    save(table, args[1], table.header.isBinary);
+
+    return EXIT_SUCCESS;
+}
+
+inline int subsample(const std::vector<std::string>& args)
+{
+    size_t every {};
+    if (args.size() == 4)
+        std::from_chars(args[3].data(), args[3].data() + args[3].size(), every);
+    if (!every)
+        throw std::invalid_argument(
+            "usage: plytool subsample <in.ply> <out.ply> <element> <every>"
+        );
+
+    auto table = load(args[0]);
+
+    const auto e = std::ranges::find(table.header.elements, args[2], &Element::name);
+    if (e == table.header.elements.end())
+        throw std::invalid_argument("no element " + args[2] + " in " + args[0]);
+
+    // Every `every`-th record is kept, in place.
+    const size_t size = e->size;
+    std::vector<bool> keep(size);
+    for (size_t i {}; i < size; i += every)
+        keep[i] = true;
+    keep_records(*e, table.columns[e - table.header.elements.begin()], keep);
+
+    // Faces keep the vertices kept, renumbered; the others are dropped.
+    for (size_t i {}; i < table.header.elements.size(); ++i) {
+
+        auto& f = table.header.elements[i];
+        std::vector<bool> kept(f.size, true);
+        bool indexed {};
+        for (size_t k {}; k < f.properties.size(); ++k) {
+
+            const auto& p = f.properties[k];
+            if (e->name != "vertex" || !is_vertex_index(f, p))
+                continue;
+            indexed = true;
+
+            const size_t n = p.is_list() ? p.listCount : 1;
+            const size_t bytes = value_bytes(p);
+            uint8_t* values = table.columns[i][k]->buffer.get();
+            for (size_t j {}; j < f.size; ++j)
+                map_indices(values + j * bytes, p.scalarType, n, [&](const int64_t v) {
+                    if (v < 0 || std::cmp_greater_equal(v, size) || v % every) {
+                        kept[j] = false;
+                        return int64_t {};
+                    }
+                    return v / static_cast<int64_t>(every);
+                });
+        }
+        if (indexed)
+            keep_records(f, table.columns[i], kept);
+    }
+
+    save(table, args[1], table.header.isBinary);
+
+    return EXIT_SUCCESS;
+}
+
+inline int merge(const std::vector<std::string>& args)
+{
+    if (args.size() < 3)
+        throw std::invalid_argument("usage: plytool merge <out.ply> <in.ply> <in.ply> ...");
+
+    std::vector<Table> tables;
+    for (size_t i = 1; i < args.size(); ++i) {
+        tables.push_back(load(args[i]));
+        if (!tables.front().header.has_schema_of(tables.back().header))
+            throw std::invalid_argument(args[i] + " does not match the schema of " +
+                                        args[1]);
+    }
+
+    // The elements of all the files, one after another; vertex indices
+    // of faces are offset by the vertices of the files before.
+    Table merged;
+    merged.header = tables.front().header;
+    merged.columns.resize(merged.header.elements.size());
+    const auto vertex = std::ranges::find(merged.header.elements, "vertex", &Element::name) -
+                        merged.header.elements.begin();
+    const bool hasVertices = vertex < std::ssize(merged.header.elements);
+
+    for (size_t i {}; i < merged.header.elements.size(); ++i) {
+
+        auto& e = merged.header.elements[i];
+        e.size = 0;
+        for (const auto& t: tables)
+            e.size += t.header.elements[i].size;
+
+        for (size_t k {}; k < e.properties.size(); ++k) {
+
+            auto& p = e.properties[k];
+            for (const auto& t: tables)
+                if (t.header.elements[i].properties[k].listCount != p.listCount)
+                    throw std::invalid_argument("lists of " + p.name +
+                                                " differ in length between the files");
+
+            const size_t bytes = value_bytes(p);
+            auto data = std::make_shared<Data>(p.scalarType,
+                                               impl::Buffer(e.size * bytes),
+                                               e.size,
+                                               p.is_list());
+            const bool indices = hasVertices && is_vertex_index(e, p);
+
+            uint8_t* dst = data->buffer.get();
+            int64_t vertices {};
+            for (const auto& t: tables) {
+                const auto& src = *t.columns[i][k];
+                const size_t n = t.header.elements[i].size * bytes;
+                std::memcpy(dst, src.buffer.get(), n);
+                if (indices)
+                    map_indices(dst, p.scalarType, n / impl::types.at(p.scalarType).stride,
+                                [&](const int64_t v) { return v + vertices; });
+                dst += n;
+                if (hasVertices)
+                    vertices += static_cast<int64_t>(t.header.elements[vertex].size);
+            }
+            merged.columns[i].push_back(data);
+        }
+    }
+
+    save(merged, args[0], merged.header.isBinary);
+
+    return EXIT_SUCCESS;
+}
+
+inline int bench(const std::vector<std::string>& args)
+{
+    if (args.empty() || args.size() > 2)
+        throw std::invalid_argument("usage: plytool bench <file.ply> [repeats]");
+
+    size_t repeats {3};
+    if (args.size() == 2)
+        std::from_chars(args[1].data(), args[1].data() + args[1].size(), repeats);
+    repeats = std::max<size_t>(1, repeats);
+
+    const double mb = static_cast<double>(fs::file_size(args[0])) * 1e-6;
+
+    // Best of `repeats` runs, in ms.
+    auto best = [&](const std::function<void()>& run) {
+        double ms {1e300};
+        for (size_t r {}; r < repeats; ++r) {
+            const auto t0 = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double, std::milli> t {
+                std::chrono::steady_clock::now() - t0
+            };
+            ms = std::min(ms, t.count());
+        }
+        return ms;
+    };
+    auto report = [&](std::string_view what, const double ms) {
+        std::cout << "  " << what << ": " << ms << " ms, "
+                  << mb / (ms * 1e-3) << " MB/s\n";
+    };
+
+    std::cout << args[0] << ", " << mb << " MB, best of " << repeats << "\n";
+
+    Table table;
+    report("read mapped", best([&] { table = load(args[0]); }));
+    report("read stream", best([&] {
+        std::ifstream is(args[0], std::ios::binary);
+        impl::FileIn file;
+        file.header.parse(is);
+        for (const auto& e: file.header.elements)
+            for (const auto& p: e.properties)
+                file.request_properties_from_element(e, {p.name}, 0);
+        file.read(is);
+    }));
+
+    // The header alone, from memory, parsed often enough to be timed.
+    {
+        const MappedFile source {args[0]};
+        const std::string_view text {reinterpret_cast<const char*>(source.bytes().data()),
+                                     source.bytes().size()};
+        impl::Header header;
+        header.parse(text);
+        const auto lines = std::ranges::count(text.substr(0, header.headerBytes), '\n');
+
+        constexpr size_t parses {10000};
+        const double ms = best([&] {
+            for (size_t i {}; i < parses; ++i) {
+                impl::Header h;
+                h.parse(text);
+            }
+        });
+        std::cout << "  parse header: " << ms / parses * 1e3 << " us, "
+                  << static_cast<double>(lines * parses) / (ms * 1e-3) << " lines/s\n";
+    }
+
+    impl::FileOut file;
+    for (size_t i {}; i < table.header.elements.size(); ++i) {
+        const auto& e = table.header.elements[i];
+        for (size_t k {}; k < e.properties.size(); ++k) {
+            const auto& p = e.properties[k];
+            file.add_properties_to_element(e.name, {p.name}, p.scalarType, e.size,
+                                           table.columns[i][k]->buffer.get(),
+                                           p.listType, p.listCount);
+        }
+    }
+    report("write binary", best([&] { file.write_to_memory(true); }));
+    report("write ascii", best([&] { file.write_to_memory(false); }));
+
+    const auto to = impl::temporary_path_for(fs::temp_directory_path() / "plytool-bench.ply");
+    report("transcode", best([&] {
+        transcode(args[0], to, table.header.isBinary ? Encoding::ASCII
+                                                     : Encoding::BINARY_LITTLE_ENDIAN);
+    }));
+    fs::remove(to);
+
+    return EXIT_SUCCESS;
+}
+
+}  // namespace tinyply::tools
+
+#endif  // TINYPLY_TOOLS_PLYTOOL_H